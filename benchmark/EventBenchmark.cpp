@@ -0,0 +1,425 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <GhrumEngineServer.hpp>
+#include <Plugin/Plugin.hpp>
+#include <Event/EventPool.hpp>
+#include <GhrumAPI.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Number of allocations done by the process.
+ */
+static std::atomic<size_t> g_Allocations(0);
+
+/////////////////////////////////////////////////////////////////
+// {@see operator new} //////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void * operator new(size_t size) {
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    void * block = std::malloc(size > 0 ? size : 1);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see operator delete} ///////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void operator delete(void * block) noexcept {
+    std::free(block);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see operator delete} ///////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void operator delete(void * block, size_t) noexcept {
+    std::free(block);
+}
+
+namespace Ghrum {
+
+/**
+ * Event emitted by every benchmark.
+ */
+struct BenchmarkEvent : public Event {
+    size_t key;
+};
+
+/**
+ * Plugin that owns every delegate of the benchmarks.
+ */
+class BenchmarkPlugin : public Plugin {
+public:
+    BenchmarkPlugin(std::string & folder, PluginDescriptor & descriptor)
+        : Plugin(folder, descriptor) {
+    }
+
+    void onLoad() {
+    }
+
+    void onDisable() {
+    }
+
+    void onEnable() {
+    }
+
+    void onUnload() {
+    }
+
+    bool isReloadAllowed() {
+        return false;
+    }
+};
+
+/**
+ * Engine that only builds the managers, no plugin is loaded.
+ */
+class BenchmarkEngine : public GhrumEngineServer {
+public:
+    void initialize() {
+        pluginManager_ = std::unique_ptr<PluginManager>(new PluginManager());
+        eventManager_  = std::unique_ptr<EventManager>(new EventManager());
+        scheduler_     = std::unique_ptr<Scheduler>(new Scheduler());
+        scheduler_->addTickDelegate(
+            Delegate<void()>(eventManager_.get(), &EventManager::emitPostedEvents));
+    }
+
+    void dispose() {
+        eventManager_->removeAll();
+    }
+};
+
+/**
+ * Listener of the benchmark events, every listener must be a different
+ * object since delegates of the same object are the same delegate.
+ */
+struct BenchmarkListener {
+    BenchmarkListener()
+        : key(0), count(0) {
+    }
+
+    void onEvent(Event &) {
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void onEventFiltered(Event & event) {
+        if (static_cast<BenchmarkEvent &>(event).key == key) {
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    size_t key;
+    std::atomic<size_t> count;
+};
+
+/**
+ * Measure the time and the allocations of a section of the benchmark.
+ */
+class BenchmarkClock {
+public:
+    BenchmarkClock()
+        : allocations_(g_Allocations.load()), start_(std::chrono::steady_clock::now()) {
+    }
+
+    void report(const char * name, size_t operations) {
+        uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - start_).count();
+        size_t allocations = g_Allocations.load() - allocations_;
+        std::printf("%-40s %12.1f ns/op %10.2f alloc/op %10zu ops\n", name,
+                    (double) nanoseconds / operations, (double) allocations / operations, operations);
+    }
+private:
+    size_t allocations_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Identifier of the event of the benchmarks.
+ */
+static const size_t kEventId = typeid(BenchmarkEvent).hash_code();
+
+/////////////////////////////////////////////////////////////////
+// {@see addListeners} //////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void addListeners(EventManager & manager, IPlugin & plugin, std::vector<std::unique_ptr<BenchmarkListener>> & list,
+                  size_t count, bool isKeyed, bool isFiltered) {
+    for (size_t i = 0; i < count; i++) {
+        list.push_back(std::unique_ptr<BenchmarkListener>(new BenchmarkListener()));
+        list.back()->key = i;
+
+        IEventManager::EventDelegate delegate(list.back().get(),
+                                              isFiltered ? &BenchmarkListener::onEventFiltered : &BenchmarkListener::onEvent);
+        if (isKeyed)
+            manager.addKeyedDelegate(plugin, delegate, EventPriority::Normal, kEventId, i);
+        else
+            manager.addDelegate(plugin, delegate, EventPriority::Normal, kEventId);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see runSyncEmit} ///////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void runSyncEmit(EventManager & manager, IPlugin & plugin, size_t listeners, size_t iterations) {
+    std::vector<std::unique_ptr<BenchmarkListener>> list;
+    addListeners(manager, plugin, list, listeners, false, false);
+
+    BenchmarkEvent event;
+    event.key = 0;
+    char name[64];
+    std::snprintf(name, sizeof(name), "sync emit, %zu listeners", listeners);
+
+    BenchmarkClock clock;
+    for (size_t i = 0; i < iterations; i++) {
+        manager.emitEvent(event, kEventId);
+    }
+    clock.report(name, iterations);
+    manager.remove(plugin);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see runKeyedEmit} //////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void runKeyedEmit(EventManager & manager, IPlugin & plugin, size_t listeners, size_t iterations) {
+    std::vector<std::unique_ptr<BenchmarkListener>> list;
+    addListeners(manager, plugin, list, listeners, true, false);
+
+    BenchmarkEvent event;
+    char name[64];
+    std::snprintf(name, sizeof(name), "keyed emit, %zu keys", listeners);
+
+    BenchmarkClock clock;
+    for (size_t i = 0; i < iterations; i++) {
+        event.key = i % listeners;
+        manager.emitEventKeyed(event, kEventId, event.key);
+    }
+    clock.report(name, iterations);
+    manager.remove(plugin);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see runFilteredEmit} ///////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void runFilteredEmit(EventManager & manager, IPlugin & plugin, size_t listeners, size_t iterations) {
+    std::vector<std::unique_ptr<BenchmarkListener>> list;
+    addListeners(manager, plugin, list, listeners, false, true);
+
+    BenchmarkEvent event;
+    char name[64];
+    std::snprintf(name, sizeof(name), "filtered emit, %zu keys", listeners);
+
+    BenchmarkClock clock;
+    for (size_t i = 0; i < iterations; i++) {
+        event.key = i % listeners;
+        manager.emitEvent(event, kEventId);
+    }
+    clock.report(name, iterations);
+    manager.remove(plugin);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see runAsyncEmit} //////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void runAsyncEmit(EventManager & manager, IPlugin & plugin, size_t listeners, size_t iterations) {
+    std::vector<std::unique_ptr<BenchmarkListener>> list;
+    addListeners(manager, plugin, list, listeners, false, false);
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "async emit, %zu listeners", listeners);
+
+    // The time includes the drain of every event, the last listener call
+    // is the end of the benchmark.
+    BenchmarkClock clock;
+    for (size_t i = 0; i < iterations; i++) {
+        std::shared_ptr<BenchmarkEvent> event = EventPool<BenchmarkEvent>::getInstance().create();
+        event->key = 0;
+        manager.emitEventAsync(event, kEventId);
+    }
+    for (auto & listener : list) {
+        while (listener->count.load(std::memory_order_relaxed) < iterations) {
+            boost::this_thread::yield();
+        }
+    }
+    clock.report(name, iterations);
+    manager.remove(plugin);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see runPostedEmit} /////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void runPostedEmit(EventManager & manager, IPlugin & plugin, size_t listeners, size_t iterations) {
+    std::vector<std::unique_ptr<BenchmarkListener>> list;
+    addListeners(manager, plugin, list, listeners, false, false);
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "posted emit, %zu listeners", listeners);
+
+    // Posted events are only emitted by the tick of the main thread,
+    // the last listener call is the end of the benchmark.
+    BenchmarkClock clock;
+    for (size_t i = 0; i < iterations; i++) {
+        std::shared_ptr<BenchmarkEvent> event = EventPool<BenchmarkEvent>::getInstance().create();
+        event->key = 0;
+        while (!manager.postEvent(event, kEventId)) {
+            boost::this_thread::yield();
+        }
+    }
+    for (auto & listener : list) {
+        while (listener->count.load(std::memory_order_relaxed) < iterations) {
+            boost::this_thread::yield();
+        }
+    }
+    clock.report(name, iterations);
+    manager.remove(plugin);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see runChurnEmit} //////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void runChurnEmit(EventManager & manager, IPlugin & plugin, IPlugin & churn, size_t listeners, size_t iterations) {
+    std::vector<std::unique_ptr<BenchmarkListener>> list;
+    addListeners(manager, plugin, list, listeners, false, false);
+
+    // Another thread registers and removes a listener of the same
+    // event for as long as the emits run.
+    std::atomic<bool> isRunning(true);
+    std::atomic<size_t> changes(0);
+    boost::thread thread([&]() {
+        BenchmarkListener listener;
+        IEventManager::EventDelegate delegate(&listener, &BenchmarkListener::onEvent);
+        while (isRunning.load(std::memory_order_relaxed)) {
+            manager.addDelegate(churn, delegate, EventPriority::Normal, kEventId);
+            manager.removeDelegate(churn, delegate, EventPriority::Normal, kEventId);
+            changes.fetch_add(2, std::memory_order_relaxed);
+        }
+    });
+
+    // The emits only start once the other thread is changing the
+    // listeners of the event.
+    while (changes.load(std::memory_order_relaxed) == 0) {
+        boost::this_thread::yield();
+    }
+
+    BenchmarkEvent event;
+    event.key = 0;
+    char name[64];
+    std::snprintf(name, sizeof(name), "sync emit under churn, %zu listeners", listeners);
+
+    BenchmarkClock clock;
+    for (size_t i = 0; i < iterations; i++) {
+        manager.emitEvent(event, kEventId);
+    }
+    clock.report(name, iterations);
+
+    isRunning = false;
+    thread.join();
+    std::printf("%-40s %12zu changes\n", "  listener churn", changes.load());
+    manager.remove(plugin);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see runRegistration} ///////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void runRegistration(EventManager & manager, IPlugin & plugin, size_t listeners) {
+    std::vector<std::unique_ptr<BenchmarkListener>> list;
+    char name[64];
+
+    {
+        std::snprintf(name, sizeof(name), "add delegate, %zu listeners", listeners);
+        BenchmarkClock clock;
+        addListeners(manager, plugin, list, listeners, true, false);
+        clock.report(name, listeners);
+    }
+    {
+        std::snprintf(name, sizeof(name), "remove delegate, %zu listeners", listeners);
+        BenchmarkClock clock;
+        for (auto & listener : list) {
+            IEventManager::EventDelegate delegate(listener.get(), &BenchmarkListener::onEvent);
+            manager.removeKeyedDelegate(plugin, delegate, EventPriority::Normal, kEventId, listener->key);
+        }
+        clock.report(name, listeners);
+    }
+
+    list.clear();
+    addListeners(manager, plugin, list, listeners, true, false);
+    {
+        std::snprintf(name, sizeof(name), "remove plugin, %zu listeners", listeners);
+        BenchmarkClock clock;
+        manager.remove(plugin);
+        clock.report(name, listeners);
+    }
+}
+
+}; // namespace Ghrum
+
+/**
+ * Entry of the benchmark.
+ *
+ * @param argc number of parameters
+ * @param argv parameters
+ * @return application exit code
+ */
+int main(int argc, char * argv[]) {
+    size_t iterations = (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000);
+
+    Ghrum::BenchmarkEngine engine;
+    Ghrum::GhrumAPI::getInstance().setInstance(&engine);
+    engine.initialize();
+
+    Ghrum::EventManager & manager = static_cast<Ghrum::EventManager &>(engine.getEventManager());
+    Ghrum::Scheduler & scheduler = static_cast<Ghrum::Scheduler &>(engine.getScheduler());
+    boost::thread thread([&]() {
+        scheduler.runMainThread();
+    });
+
+    std::string folder = "benchmark";
+    Ghrum::PluginDescriptor descriptor;
+    descriptor.Name = "Benchmark";
+    descriptor.Identifier = 1;
+    Ghrum::BenchmarkPlugin plugin(folder, descriptor);
+    descriptor.Name = "Churn";
+    descriptor.Identifier = 2;
+    Ghrum::BenchmarkPlugin churn(folder, descriptor);
+
+    for (size_t listeners : {
+                0, 1, 10, 1000
+            }) {
+        Ghrum::runSyncEmit(manager, plugin, listeners, listeners < 1000 ? iterations : iterations / 100);
+    }
+    Ghrum::runKeyedEmit(manager, plugin, 1000, iterations);
+    Ghrum::runFilteredEmit(manager, plugin, 1000, iterations / 100);
+    for (size_t listeners : {
+                1, 10
+            }) {
+        Ghrum::runAsyncEmit(manager, plugin, listeners, iterations);
+        Ghrum::runPostedEmit(manager, plugin, listeners, iterations);
+    }
+    Ghrum::runChurnEmit(manager, plugin, churn, 10, iterations);
+    for (size_t listeners : {
+                1000, 10000
+            }) {
+        Ghrum::runRegistration(manager, plugin, listeners);
+    }
+
+    scheduler.setCancelled();
+    thread.join();
+    engine.dispose();
+    return 0;
+}
@@ -0,0 +1,675 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <GhrumEngineServer.hpp>
+#include <GhrumAPI.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace Ghrum {
+
+/**
+ * Period of the pacer of every client reactor, in microseconds.
+ */
+#define BENCHMARK_PACE_PERIOD 1000
+
+/**
+ * Number of bytes a client may have waiting to be written before it
+ * stops generating messages.
+ */
+#define BENCHMARK_OUTPUT_LIMIT 1048576
+
+/**
+ * Enumeration of the messages of the benchmark, every message starts
+ * with its kind and the time it was sent at.
+ */
+enum class BenchmarkKind : uint8_t {
+    Ping,
+    Move,
+    Chat,
+    Sign,
+    Bulk,
+    Count
+};
+
+/**
+ * Name of every message, as given in the mix.
+ */
+static const char * kKindName[] = {
+    "ping", "move", "chat", "sign", "bulk"
+};
+
+/**
+ * Length of the frame of every reply, the kind and the time of the
+ * message.
+ */
+static const size_t kReplyLength = 1 + sizeof(uint64_t);
+
+/////////////////////////////////////////////////////////////////
+// {@see getTime} ///////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+static inline uint64_t getTime() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Histogram of values with 32 buckets per power of two, so every
+ * percentile is within 3% of the real value.
+ */
+class BenchmarkHistogram {
+public:
+    BenchmarkHistogram()
+        : bucket_(1920, 0), count_(0), maximum_(0) {
+    }
+
+    void add(uint64_t value) {
+        size_t index = value;
+        if (value >= 64) {
+            size_t shift = (63 - __builtin_clzll(value)) - 5;
+            index = (shift + 1) * 32 + ((value >> shift) & 31);
+        }
+        bucket_[index]++;
+        count_++;
+        maximum_ = std::max(maximum_, value);
+    }
+
+    void merge(const BenchmarkHistogram & other) {
+        for (size_t i = 0; i < bucket_.size(); i++) {
+            bucket_[i] += other.bucket_[i];
+        }
+        count_ += other.count_;
+        maximum_ = std::max(maximum_, other.maximum_);
+    }
+
+    uint64_t getPercentile(double percentile) const {
+        uint64_t target = uint64_t(percentile / 100.0 * count_), sum = 0;
+        for (size_t i = 0; i < bucket_.size(); i++) {
+            sum += bucket_[i];
+            if (sum > target) {
+                return (i < 64 ? i : uint64_t(32 + (i & 31)) << ((i >> 5) - 1));
+            }
+        }
+        return maximum_;
+    }
+
+    uint64_t getCount() const {
+        return count_;
+    }
+
+    uint64_t getMaximum() const {
+        return maximum_;
+    }
+private:
+    std::vector<uint64_t> bucket_;
+    uint64_t count_, maximum_;
+};
+
+/**
+ * A message encoded once and copied by every client that sends it.
+ */
+struct BenchmarkFrame {
+    MessageBuffer data;
+    size_t timeOffset;
+};
+
+/**
+ * Settings of a run of the benchmark.
+ */
+struct BenchmarkSettings {
+    size_t sessions, rate, seconds, reactors, clientReactors;
+    std::vector<BenchmarkKind> schedule;
+};
+
+/**
+ * Counters of a client reactor, only touched by its thread until the
+ * reactor is stopped.
+ */
+struct BenchmarkCounters {
+    BenchmarkCounters()
+        : sent(0), received(0), bytesSent(0), bytesReceived(0), throttled(0) {
+    }
+
+    uint64_t sent, received, bytesSent, bytesReceived, throttled;
+    BenchmarkHistogram latency;
+};
+
+/**
+ * Engine that only builds the managers, no plugin is loaded.
+ */
+class BenchmarkEngine : public GhrumEngineServer {
+public:
+    void initialize() {
+        pluginManager_  = std::unique_ptr<PluginManager>(new PluginManager());
+        eventManager_   = std::unique_ptr<EventManager>(new EventManager());
+        scheduler_      = std::unique_ptr<Scheduler>(new Scheduler());
+        sessionManager_ = std::unique_ptr<SessionManager>(new SessionManager());
+        scheduler_->addTickDelegate(
+            Delegate<void()>(eventManager_.get(), &EventManager::emitPostedEvents));
+        scheduler_->addTickDelegate(
+            Delegate<void()>(sessionManager_.get(), &SessionManager::flush));
+    }
+
+    void dispose() {
+        sessionManager_->stop();
+    }
+};
+
+/**
+ * Measure the health of the ticks of the scheduler, called at the end
+ * of every tick from the main thread. It is only reported once the main
+ * thread has stopped.
+ */
+class BenchmarkTickMonitor {
+public:
+    BenchmarkTickMonitor(Scheduler & scheduler)
+        : scheduler_(scheduler), ticks_(0), overloaded_(0), last_(0), start_(0), end_(0), isRecording_(false) {
+    }
+
+    void onTick() {
+        uint64_t now = getTime();
+        if (isRecording_.load(std::memory_order_relaxed)) {
+            if (start_ == 0) {
+                start_ = now;
+            } else {
+                gap_.add(now - last_);
+            }
+            ticks_++;
+            overloaded_ += (scheduler_.isOverloaded() ? 1 : 0);
+            end_ = now;
+        }
+        last_ = now;
+    }
+
+    void setRecording(bool isRecording) {
+        isRecording_ = isRecording;
+    }
+
+    void report() {
+        double seconds = (end_ - start_) / 1e9;
+        std::printf("%-40s %12.1f ticks/s %10zu overloaded\n", "server ticks",
+                    seconds > 0 ? ticks_ / seconds : 0.0, overloaded_);
+        std::printf("%-40s %12.3f ms p50 %10.3f ms p99 %10.3f ms max\n", "  time between ticks",
+                    gap_.getPercentile(50) / 1e6, gap_.getPercentile(99) / 1e6, gap_.getMaximum() / 1e6);
+    }
+private:
+    Scheduler & scheduler_;
+    size_t ticks_, overloaded_;
+    uint64_t last_, start_, end_;
+    std::atomic<bool> isRecording_;
+    BenchmarkHistogram gap_;
+};
+
+/**
+ * Decode every message received by the server and reply with its kind
+ * and time, the reply is written at the end of the tick.
+ */
+class BenchmarkServer {
+public:
+    BenchmarkServer()
+        : checksum_(0) {
+    }
+
+    void onMessage(Session & session, MessageInputStream & stream) {
+        uint8_t kind = stream.readUnsignedByte();
+        uint64_t time = stream.readUnsignedLong();
+        uint64_t checksum = 0;
+
+        switch (BenchmarkKind(kind)) {
+        case BenchmarkKind::Ping:
+            break;
+        case BenchmarkKind::Move: {
+            checksum += stream.readVarUnsignedInteger();
+            float position[5];
+            stream.readFloatArray(position, 5);
+            checksum += uint64_t(position[0] + position[1] + position[2]);
+            checksum += stream.readBoolean();
+            break;
+        }
+        case BenchmarkKind::Chat:
+            checksum += stream.readVarStringView().size();
+            break;
+        case BenchmarkKind::Sign: {
+            std::string & text = getText();
+            for (size_t i = 0; i < 4; i++) {
+                stream.readUnicode(text);
+                checksum += text.size();
+            }
+            break;
+        }
+        case BenchmarkKind::Bulk: {
+            int32_t block[64];
+            for (size_t length = stream.readVarUnsignedInteger(); length > 0;) {
+                size_t count = std::min<size_t>(length, 64);
+                stream.readIntegerArray(block, count);
+                checksum += block[count - 1];
+                length -= count;
+            }
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown message of the benchmark");
+        }
+        checksum_.fetch_add(checksum, std::memory_order_relaxed);
+
+        int8_t reply[1 + kReplyLength] = { int8_t(kReplyLength), int8_t(kind) };
+        std::memcpy(reply + 2, &time, sizeof(time));
+        session.send(reply, sizeof(reply));
+    }
+
+    uint64_t getChecksum() {
+        return checksum_.load();
+    }
+private:
+    static std::string & getText() {
+        static thread_local std::string text;
+        return text;
+    }
+private:
+    std::atomic<uint64_t> checksum_;
+};
+
+/**
+ * A simulated session, sending messages at a fixed rate and measuring
+ * the time until the reply of each one. A client is only touched by the
+ * thread of its reactor.
+ */
+class BenchmarkClient {
+public:
+    BenchmarkClient(Reactor & reactor, size_t id, BenchmarkCounters & counters, const std::atomic<uint64_t> & start)
+        : id_(id), socket_(reactor.getService()), generated_(0), isWriting_(false),
+          parser_(MessageFramePrefix::Varint), counters_(counters), start_(start) {
+    }
+
+    boost::asio::ip::tcp::socket & getSocket() {
+        return socket_;
+    }
+
+    void start() {
+        boost::system::error_code error;
+        socket_.set_option(boost::asio::ip::tcp::no_delay(true), error);
+        doRead();
+    }
+
+    void pace(const std::vector<BenchmarkFrame> & frames, const BenchmarkSettings & settings, uint64_t elapsed) {
+        // Every message owed since the start is generated at once, the
+        // schedule is shifted per client so each one sends a mix.
+        uint64_t owed = elapsed * settings.rate / 1000000000ULL;
+        if (owed <= generated_) {
+            return;
+        }
+        if (pending_.getLength() >= BENCHMARK_OUTPUT_LIMIT) {
+            counters_.throttled += owed - generated_;
+            generated_ = owed;
+            return;
+        }
+
+        uint64_t time = getTime();
+        bool isRecording = (time >= start_.load(std::memory_order_relaxed));
+        for (; generated_ < owed; generated_++) {
+            const BenchmarkFrame & frame
+                = frames[size_t(settings.schedule[(generated_ + id_) % settings.schedule.size()])];
+            size_t length = frame.data.getLength();
+            int8_t * data = pending_.prepare(length);
+            std::memcpy(data, frame.data.getData(), length);
+            std::memcpy(data + frame.timeOffset, &time, sizeof(time));
+            pending_.commit(length);
+
+            if (isRecording) {
+                counters_.sent++;
+                counters_.bytesSent += length;
+            }
+        }
+        if (!isWriting_) {
+            doWrite();
+        }
+    }
+private:
+    void doRead() {
+        int8_t * buffer = input_.prepare(SESSION_READ_LENGTH);
+        socket_.async_read_some(boost::asio::buffer(buffer, SESSION_READ_LENGTH),
+        [this](const boost::system::error_code & error, size_t length) {
+            onRead(error, length);
+        });
+    }
+
+    void onRead(const boost::system::error_code & error, size_t length) {
+        if (error) {
+            return;
+        }
+        input_.commit(length);
+
+        // Only the replies of messages sent once the measure started
+        // are counted.
+        uint64_t now = getTime(), start = start_.load(std::memory_order_relaxed);
+        size_t offset, size;
+        while (parser_.next(input_.getData(), input_.getLength(), offset, size)) {
+            uint64_t time;
+            std::memcpy(&time, input_.getData() + offset + 1, sizeof(time));
+            if (time >= start) {
+                counters_.received++;
+                counters_.bytesReceived += offset + size;
+                counters_.latency.add(now - time);
+            }
+            input_.consume(offset + size);
+        }
+        doRead();
+    }
+
+    void doWrite() {
+        std::swap(pending_, sending_);
+        isWriting_ = true;
+        boost::asio::async_write(socket_, boost::asio::buffer(sending_.getData(), sending_.getLength()),
+        [this](const boost::system::error_code & error, size_t) {
+            isWriting_ = false;
+            sending_.clear();
+            if (!error && pending_.getLength() > 0) {
+                doWrite();
+            }
+        });
+    }
+private:
+    size_t id_;
+    boost::asio::ip::tcp::socket socket_;
+    uint64_t generated_;
+    bool isWriting_;
+    MessageFrameParser parser_;
+    MessageBuffer input_, pending_, sending_;
+    BenchmarkCounters & counters_;
+    const std::atomic<uint64_t> & start_;
+};
+
+/**
+ * A reactor of simulated sessions, paced by a single timer.
+ */
+class BenchmarkClientReactor {
+public:
+    BenchmarkClientReactor(size_t id, const std::vector<BenchmarkFrame> & frames, const BenchmarkSettings & settings,
+                           const std::atomic<uint64_t> & start)
+        : reactor_(id), timer_(reactor_.getService()), frames_(frames), settings_(settings), start_(start),
+          isRunning_(true) {
+    }
+
+    BenchmarkCounters & getCounters() {
+        return counters_;
+    }
+
+    BenchmarkClient & add(size_t id) {
+        client_.push_back(std::unique_ptr<BenchmarkClient>(new BenchmarkClient(reactor_, id, counters_, start_)));
+        return *client_.back();
+    }
+
+    void start() {
+        reactor_.getService().post([this]() {
+            for (auto & client : client_) {
+                client->start();
+            }
+            epoch_ = getTime();
+            doPace();
+        });
+        reactor_.start();
+    }
+
+    void setRunning(bool isRunning) {
+        isRunning_ = isRunning;
+    }
+
+    void stop() {
+        reactor_.stop();
+        client_.clear();
+    }
+private:
+    void doPace() {
+        if (!isRunning_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        uint64_t elapsed = getTime() - epoch_;
+        for (auto & client : client_) {
+            client->pace(frames_, settings_, elapsed);
+        }
+        timer_.expires_from_now(boost::posix_time::microseconds(BENCHMARK_PACE_PERIOD));
+        timer_.async_wait([this](const boost::system::error_code & error) {
+            if (!error) {
+                doPace();
+            }
+        });
+    }
+private:
+    Reactor reactor_;
+    boost::asio::deadline_timer timer_;
+    const std::vector<BenchmarkFrame> & frames_;
+    const BenchmarkSettings & settings_;
+    const std::atomic<uint64_t> & start_;
+    std::atomic<bool> isRunning_;
+    uint64_t epoch_;
+    BenchmarkCounters counters_;
+    std::vector<std::unique_ptr<BenchmarkClient>> client_;
+};
+
+/////////////////////////////////////////////////////////////////
+// {@see parseMix} //////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+std::vector<BenchmarkKind> parseMix(const std::string & mix) {
+    // The mix is a list of kind:weight, each kind appears as many times
+    // as its weight in the schedule of every client.
+    std::vector<BenchmarkKind> schedule;
+    size_t position = 0;
+    while (position < mix.size()) {
+        size_t end = mix.find(',', position);
+        std::string entry = mix.substr(position, end == std::string::npos ? std::string::npos : end - position);
+        position = (end == std::string::npos ? mix.size() : end + 1);
+
+        size_t separator = entry.find(':');
+        std::string name = entry.substr(0, separator);
+        size_t weight = (separator == std::string::npos ? 1 : std::strtoul(entry.c_str() + separator + 1, nullptr, 10));
+        size_t kind = 0;
+        while (kind < size_t(BenchmarkKind::Count) && name != kKindName[kind]) {
+            kind++;
+        }
+        if (kind == size_t(BenchmarkKind::Count)) {
+            throw std::invalid_argument("Unknown message in the mix: " + name);
+        }
+        schedule.insert(schedule.end(), weight, BenchmarkKind(kind));
+    }
+    if (schedule.empty()) {
+        throw std::invalid_argument("The mix has no message");
+    }
+    return schedule;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see createFrames} //////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+std::vector<BenchmarkFrame> createFrames() {
+    // Every message is encoded once, clients copy the frame and patch
+    // the time in it.
+    std::vector<BenchmarkFrame> frames;
+    for (size_t kind = 0; kind < size_t(BenchmarkKind::Count); kind++) {
+        MessageBuffer body;
+        MessageOutputStream stream(body);
+        stream.setEndianness(false);
+        stream.writeUnsignedByte(uint8_t(kind));
+        stream.writeUnsignedLong(0);
+
+        switch (BenchmarkKind(kind)) {
+        case BenchmarkKind::Move: {
+            const float position[5] = { 128.5f, 64.0f, -312.25f, 90.0f, 12.5f };
+            stream.writeVarUnsignedInteger(4242);
+            stream.writeFloatArray(position, 5);
+            stream.writeBoolean(true);
+            break;
+        }
+        case BenchmarkKind::Chat:
+            stream.writeVarString("Anyone up for a round in the north arena? Bring some torches, it is dark.");
+            break;
+        case BenchmarkKind::Sign:
+            for (size_t i = 0; i < 4; i++) {
+                stream.writeUnicode(u"Welcome to the spawn town");
+            }
+            break;
+        case BenchmarkKind::Bulk: {
+            std::vector<int32_t> block(1024);
+            for (size_t i = 0; i < block.size(); i++) {
+                block[i] = int32_t(i * 2654435761U);
+            }
+            stream.writeVarUnsignedInteger(uint32_t(block.size()));
+            stream.writeIntegerArray(block.data(), block.size());
+            break;
+        }
+        default:
+            break;
+        }
+
+        // The time follows the prefix of the frame and the kind.
+        BenchmarkFrame frame;
+        MessageOutputStream prefix(frame.data);
+        prefix.writeVarUnsignedInteger(uint32_t(body.getLength()));
+        frame.timeOffset = prefix.getLength() + 1;
+        prefix.writeBytes(body.getData(), body.getLength());
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see runLoad} ///////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void runLoad(BenchmarkEngine & engine, BenchmarkTickMonitor & monitor, const BenchmarkSettings & settings) {
+    SessionManager & manager = engine.getSessionManager();
+    BenchmarkServer server;
+    std::atomic<size_t> connected(0);
+    manager.setFrameParser(MessageFrameParser(MessageFramePrefix::Varint));
+    manager.setConnectDelegate(SessionManager::SessionDelegate([&](Session &) {
+        connected.fetch_add(1);
+    }));
+    manager.setMessageDelegate(SessionManager::MessageDelegate(&server, &BenchmarkServer::onMessage));
+    manager.start("127.0.0.1", 0, settings.reactors);
+
+    // Every client connects before any of them starts sending.
+    std::vector<BenchmarkFrame> frames = createFrames();
+    std::atomic<uint64_t> start(UINT64_MAX);
+    std::vector<std::unique_ptr<BenchmarkClientReactor>> reactors;
+    for (size_t i = 0; i < settings.clientReactors; i++) {
+        reactors.push_back(std::unique_ptr<BenchmarkClientReactor>(
+                               new BenchmarkClientReactor(i, frames, settings, start)));
+    }
+    boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::address::from_string("127.0.0.1"), manager.getPort());
+    for (size_t i = 0; i < settings.sessions; i++) {
+        reactors[i % reactors.size()]->add(i).getSocket().connect(endpoint);
+    }
+    while (connected.load() < settings.sessions) {
+        boost::this_thread::yield();
+    }
+
+    // The first second warms up the connections and the allocator, only
+    // messages sent after it are measured.
+    for (auto & reactor : reactors) {
+        reactor->start();
+    }
+    boost::this_thread::sleep(boost::posix_time::seconds(1));
+    uint64_t writes = manager.getWriteCount(), messages = manager.getMessageCount();
+    start = getTime();
+    monitor.setRecording(true);
+
+    boost::this_thread::sleep(boost::posix_time::seconds(settings.seconds));
+    uint64_t end = getTime();
+    monitor.setRecording(false);
+    writes = manager.getWriteCount() - writes;
+    messages = manager.getMessageCount() - messages;
+
+    // The replies of the last messages are given time to arrive.
+    for (auto & reactor : reactors) {
+        reactor->setRunning(false);
+    }
+    boost::this_thread::sleep(boost::posix_time::milliseconds(500));
+    for (auto & reactor : reactors) {
+        reactor->stop();
+    }
+
+    BenchmarkCounters total;
+    for (auto & reactor : reactors) {
+        BenchmarkCounters & counters = reactor->getCounters();
+        total.sent += counters.sent;
+        total.received += counters.received;
+        total.bytesSent += counters.bytesSent;
+        total.bytesReceived += counters.bytesReceived;
+        total.throttled += counters.throttled;
+        total.latency.merge(counters.latency);
+    }
+
+    double seconds = (end - start.load()) / 1e9;
+    std::printf("%-40s %12zu sessions %8zu msg/s each %6zu reactors\n", "load",
+                settings.sessions, settings.rate, manager.getReactorCount());
+    std::printf("%-40s %12.0f msg/s %12.2f MB/s\n", "client to server",
+                total.sent / seconds, total.bytesSent / seconds / 1e6);
+    std::printf("%-40s %12.0f msg/s %12.2f MB/s\n", "server to client",
+                total.received / seconds, total.bytesReceived / seconds / 1e6);
+    std::printf("%-40s %12.1f us p50 %10.1f us p99 %10.1f us max\n", "  round trip",
+                total.latency.getPercentile(50) / 1e3, total.latency.getPercentile(99) / 1e3,
+                total.latency.getMaximum() / 1e3);
+    std::printf("%-40s %12llu lost %10llu throttled\n", "  unanswered",
+                (unsigned long long)(total.sent - std::min(total.sent, total.received)),
+                (unsigned long long) total.throttled);
+    std::printf("%-40s %12.0f writes/s %10.1f msg/write\n", "server writes",
+                writes / seconds, writes > 0 ? (double) messages / writes : 0.0);
+    std::printf("%-40s %12llx\n", "  checksum", (unsigned long long) server.getChecksum());
+}
+
+}; // namespace Ghrum
+
+/**
+ * Entry of the benchmark.
+ *
+ * @param argc number of parameters
+ * @param argv parameters
+ * @return application exit code
+ */
+int main(int argc, char * argv[]) {
+    Ghrum::BenchmarkSettings settings;
+    try {
+        settings.schedule = Ghrum::parseMix(argc > 4 ? argv[4] : "ping:1,move:6,chat:2,sign:1");
+    } catch (std::invalid_argument & ex) {
+        std::printf("%s\nUsage: %s [sessions] [rate] [seconds] [kind:weight,...] [reactors]\n", ex.what(), argv[0]);
+        return 1;
+    }
+    settings.sessions = (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100);
+    settings.rate = (argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100);
+    settings.seconds = (argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10);
+    settings.reactors = (argc > 5 ? std::strtoul(argv[5], nullptr, 10) : 0);
+    settings.clientReactors = std::max<size_t>(1, boost::thread::hardware_concurrency() / 2);
+
+    Ghrum::BenchmarkEngine engine;
+    Ghrum::GhrumAPI::getInstance().setInstance(&engine);
+    engine.initialize();
+
+    Ghrum::Scheduler & scheduler = static_cast<Ghrum::Scheduler &>(engine.getScheduler());
+    Ghrum::BenchmarkTickMonitor monitor(scheduler);
+    scheduler.addTickDelegate(Ghrum::Delegate<void()>(&monitor, &Ghrum::BenchmarkTickMonitor::onTick));
+    boost::thread thread([&]() {
+        scheduler.runMainThread();
+    });
+
+    Ghrum::runLoad(engine, monitor, settings);
+
+    scheduler.setCancelled();
+    thread.join();
+    monitor.report();
+    engine.dispose();
+    return 0;
+}
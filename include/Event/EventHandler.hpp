@@ -16,7 +16,7 @@
 #ifndef _EVENT_HANDLER_HPP_
 #define _EVENT_HANDLER_HPP_
 
-#include <Event/IEventManager.hpp>
+#include "EventMetrics.hpp"
 
 namespace Ghrum {
 
@@ -25,8 +25,24 @@ namespace Ghrum {
  *
  * @author Agustin Alvarez <wolftein@ghrum.org>
  */
-class EventHandler {
+class EventHandler : public std::enable_shared_from_this<EventHandler> {
+private:
+    /**
+     * Define a delegate along with the counters of its latency.
+     */
+    struct Slot {
+        IEventManager::EventDelegate function;
+        EventMetrics::Counter * counter;
+    };
 public:
+    /**
+     * Default constructor of the handler.
+     *
+     * @param id the id of the event
+     * @param metrics the metrics where to record the latency of each delegate
+     */
+    EventHandler(size_t id, EventMetrics & metrics);
+
     /**
      * Return if the handler is empty.
      */
@@ -40,24 +56,79 @@ public:
     void callEvent(Event & event);
 
     /**
-     * Connect a new delegate into the handler.
+     * Emit an event into all delegates that aren't keyed, and those
+     * keyed with the given key.
+     *
+     * @param event the event to push
+     * @param key the routing key of the event
+     */
+    void callEvent(Event & event, size_t key);
+
+    /**
+     * Emit an event into all delegates, delegates with {@see EventPriority::Monitor}
+     * only observe the event so they are pushed together to the worker pool
+     * once every other delegate has been called.
+     *
+     * @param event the event to push
+     * @param key the routing key of the event or nullptr
+     * @param completion the delegate called after every other delegate or nullptr
+     */
+    void callEventAsync(std::shared_ptr<Event> event, const size_t * key,
+                        const IEventManager::EventDelegate * completion);
+
+    /**
+     * Connect a new delegate into the handler, the caller must ensure it
+     * isn't connected already.
      *
      * @param function pointer to the delegate function
      * @param priority priority of the delegate
-     * @return true if the delegate was added succesfull
+     * @param owner the id of the owner of the delegate
      */
-    bool addDelegate(IEventManager::EventDelegate function, EventPriority priority);
+    void addDelegate(IEventManager::EventDelegate function, EventPriority priority, size_t owner);
 
     /**
-     * Removes a delegate from the handler.
+     * Connect a new delegate into the handler, the delegate is only called
+     * for events emitted with the given key. The caller must ensure it
+     * isn't connected already.
      *
      * @param function pointer to the delegate function
      * @param priority priority of the delegate
-     * @return true if the delegate was removed succesfull
+     * @param owner the id of the owner of the delegate
+     * @param key the routing key of the delegate
+     */
+    void addDelegate(IEventManager::EventDelegate function, EventPriority priority, size_t owner, size_t key);
+private:
+    /**
+     * Return the delegates keyed with the given key or nullptr.
+     *
+     * @param priority priority of the delegates
+     * @param key the routing key of the delegates
+     */
+    std::vector<Slot> * getDelegates(int priority, size_t key);
+
+    /**
+     * Call every delegate of a priority.
+     *
+     * @param event the event to push
+     * @param priority priority of the delegates
+     * @param key the routing key of the event or nullptr
+     * @param isSampled if the latency of each delegate must be recorded
+     */
+    void callDelegates(Event & event, int priority, const size_t * key, bool isSampled);
+
+    /**
+     * Call a delegate, recording its latency if sampled.
+     *
+     * @param event the event to push
+     * @param slot the delegate to call
+     * @param isSampled if the latency of the delegate must be recorded
      */
-    bool removeDelegate(IEventManager::EventDelegate function, EventPriority priority);
+    static void callDelegate(Event & event, const Slot & slot, bool isSampled);
 private:
-    std::vector<IEventManager::EventDelegate> delegates_[EventPriority::Monitor + 1];
+    size_t id_;
+    EventMetrics & metrics_;
+    std::vector<Slot> delegates_[EventPriority::Monitor + 1];
+    std::unordered_map<size_t, std::vector<Slot>> keyed_[EventPriority::Monitor + 1];
 };
 
 }; // namespace Ghrum
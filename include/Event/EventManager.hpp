@@ -17,6 +17,8 @@
 #define _EVENT_MANAGER_HPP_
 
 #include "EventHandler.hpp"
+#include "EventQueue.hpp"
+#include <list>
 
 namespace Ghrum {
 
@@ -27,6 +29,11 @@ namespace Ghrum {
  */
 class EventManager : public IEventManager {
 public:
+    /**
+     * Default constructor of the manager.
+     */
+    EventManager();
+
     /**
      * {@inheritDoc}
      */
@@ -46,7 +53,7 @@ public:
      * {@inheritDoc}
      */
     void removeAll();
-private:
+
     /**
      * {@inheritDoc}
      */
@@ -71,15 +78,282 @@ private:
      * {@inheritDoc}
      */
     bool removeDelegate(IPlugin & owner, EventDelegate & callback, EventPriority priority, size_t id);
+
+    /**
+     * Emit an event asynchronously, discarding every pending event
+     * of the same id that was emitted with the same key.
+     *
+     * @param event the event to push
+     * @param id the id of the event
+     * @param key the key to coalesce the event with
+     */
+    void emitEventCoalesced(std::shared_ptr<Event> event, size_t id, size_t key);
+
+    /**
+     * Emit an event into every delegate that isn't keyed, and those
+     * keyed with the given key.
+     *
+     * @param event the event to push
+     * @param id the id of the event
+     * @param key the routing key of the event
+     */
+    void emitEventKeyed(Event & event, size_t id, size_t key);
+
+    /**
+     * Emit an event asynchronously into every delegate that isn't keyed,
+     * and those keyed with the given key.
+     *
+     * @param event the event to push
+     * @param id the id of the event
+     * @param key the routing key of the event
+     */
+    void emitEventKeyedAsync(std::shared_ptr<Event> event, size_t id, size_t key);
+
+    /**
+     * Emit an event asynchronously, events emitted with the same ordering
+     * key are emitted one after the other in the order they were emitted,
+     * while events with different keys are emitted in parallel.
+     *
+     * @param event the event to push
+     * @param id the id of the event
+     * @param key the ordering key of the event
+     */
+    void emitEventOrdered(std::shared_ptr<Event> event, size_t id, size_t key);
+
+    /**
+     * Post an event to be emitted in the main thread, the event is emitted
+     * at the end of the current tick, after every event posted before it
+     * by the same thread. The caller never blocks.
+     *
+     * @param event the event to push
+     * @param id the id of the event
+     * @return false if the event was discarded because there are too many
+     *         events waiting
+     */
+    bool postEvent(std::shared_ptr<Event> event, size_t id);
+
+    /**
+     * Return the number of events waiting to be emitted in the
+     * main thread.
+     */
+    size_t getPostedLength();
+
+    /**
+     * Emit every event posted to the main thread, must be called
+     * only from the main thread.
+     */
+    void emitPostedEvents();
+
+    /**
+     * Connect a delegate that is only called for events emitted
+     * with the given key.
+     *
+     * @param owner the owner of the delegate
+     * @param callback the delegate function
+     * @param priority priority of the delegate
+     * @param id the id of the event
+     * @param key the routing key of the delegate
+     * @return true if the delegate was added succesfull
+     */
+    bool addKeyedDelegate(IPlugin & owner, EventDelegate & callback, EventPriority priority, size_t id, size_t key);
+
+    /**
+     * Removes a keyed delegate.
+     *
+     * @param owner the owner of the delegate
+     * @param callback the delegate function
+     * @param priority priority of the delegate
+     * @param id the id of the event
+     * @param key the routing key of the delegate
+     * @return true if the delegate was removed succesfull
+     */
+    bool removeKeyedDelegate(IPlugin & owner, EventDelegate & callback, EventPriority priority, size_t id, size_t key);
+
+    /**
+     * Return the latency metrics of every delegate.
+     */
+    EventMetrics & getMetrics();
+
+    /**
+     * Sets the parent of an event, every delegate of the parent and its
+     * ancestors is called when the event is emitted.
+     *
+     * @param id the id of the event
+     * @param parent the id of the parent event
+     * @return true if the parent was set succesfull
+     */
+    bool setParent(size_t id, size_t parent);
+private:
+    /**
+     * Emit an event that is owned by the asynchronous queue.
+     *
+     * @param event the event to push
+     * @param id the id of the event
+     * @param key the routing key of the event or nullptr
+     * @param isOrdered if every delegate must be called before returning
+     * @param completion the delegate called after every other delegate or nullptr
+     */
+    void emitEventShared(std::shared_ptr<Event> event, size_t id, const size_t * key, bool isOrdered,
+                         const EventDelegate * completion);
+
+    /**
+     * Register a delegate, the lock must be held by the caller.
+     *
+     * @param owner the owner of the delegate
+     * @param callback the delegate function
+     * @param priority priority of the delegate
+     * @param id the id of the event
+     * @param key the routing key of the delegate
+     * @param isKeyed if the routing key applies
+     * @return true if the delegate was added succesfull
+     */
+    bool insertDelegate(IPlugin & owner, EventDelegate & callback, EventPriority priority, size_t id, size_t key,
+                        bool isKeyed);
+
+    /**
+     * Unregister a delegate, the lock must be held by the caller.
+     *
+     * @param owner the owner of the delegate
+     * @param callback the delegate function
+     * @param priority priority of the delegate
+     * @param id the id of the event
+     * @param key the routing key of the delegate
+     * @param isKeyed if the routing key applies
+     * @return true if the delegate was removed succesfull
+     */
+    bool eraseDelegate(IPlugin & owner, EventDelegate & callback, EventPriority priority, size_t id, size_t key,
+                       bool isKeyed);
+
+    /**
+     * Build the dispatch handler of an event and its descendants, which
+     * has the delegates of the event followed by those of its ancestors.
+     *
+     * @param id the id of the event
+     */
+    void rebuildDispatch(size_t id);
+
+    /**
+     * Publish the index of the dispatch cells to every emitting thread
+     * if a cell was created since the last time, the lock must be held
+     * by the caller.
+     */
+    void publishDispatch();
+
+    /**
+     * Push an entry into its asynchronous queue.
+     *
+     * @param entry the entry to push
+     */
+    void pushEventAsync(EventQueue::Entry * entry);
+
+    /**
+     * Schedule a task to drain an asynchronous queue, the caller must
+     * own the drain of the queue.
+     *
+     * @param queue the queue to drain
+     */
+    void scheduleEventAsync(EventQueue & queue);
+
+    /**
+     * Emit every entry pending in the given queue.
+     *
+     * @param queue the queue to drain
+     */
+    void drainEventAsync(EventQueue & queue);
 private:
     /**
-     * A type definition of a tuple that the manager use.
+     * Define the dispatch handler of an event, which is replaced as a
+     * whole and never modified once built. A cell lives as long as the
+     * manager, so emitting threads can hold its address without a lock.
+     */
+    struct DispatchCell {
+        std::shared_ptr<EventHandler> handler;
+    };
+
+    /**
+     * A type definition of the index of the dispatch cells of every
+     * event, only published again when a cell is created.
+     */
+    typedef std::unordered_map<size_t, DispatchCell *> DispatchMap;
+
+    /**
+     * Define a delegate registered by a plugin, index is the position of
+     * its handle in the list of handles of the owner.
+     */
+    struct Registration {
+        EventDelegate function;
+        EventPriority priority;
+        size_t id, owner, key, index;
+        bool isKeyed;
+    };
+
+    /**
+     * A type definition of the registrations of an event, iterators
+     * of the list remain valid until the registration is erased.
+     */
+    typedef std::list<Registration> RegistrationList;
+
+    /**
+     * A type definition of a handle to a registration, made of the
+     * event id and the position of the registration.
+     */
+    typedef std::pair<size_t, RegistrationList::iterator> Handle;
+
+    /**
+     * A type definition of the index of every registration, delegates
+     * can only be compared so they are grouped by everything else.
+     */
+    typedef std::unordered_multimap<size_t, RegistrationList::iterator> RegistrationIndex;
+
+    /**
+     * Return the key of a registration in the index.
+     *
+     * @param id the id of the event
+     * @param owner the id of the owner of the delegate
+     * @param priority priority of the delegate
+     * @param key the routing key of the delegate
+     * @param isKeyed if the routing key applies
+     */
+    static size_t getIndexKey(size_t id, size_t owner, EventPriority priority, size_t key, bool isKeyed);
+
+    /**
+     * Find a registration in the index, the lock must be held by
+     * the caller.
+     *
+     * @param id the id of the event
+     * @param owner the id of the owner of the delegate
+     * @param callback the delegate function
+     * @param priority priority of the delegate
+     * @param key the routing key of the delegate
+     * @param isKeyed if the routing key applies
+     * @return the position of the registration in the index or its end
+     */
+    RegistrationIndex::iterator findDelegate(size_t id, size_t owner, const EventDelegate & callback,
+                                             EventPriority priority, size_t key, bool isKeyed);
+
+    /**
+     * Return the dispatch handler of an event or nullptr, can be called
+     * from any thread without the lock.
+     *
+     * @param id the id of the event
      */
-    typedef std::tuple<EventDelegate, EventPriority, size_t> ListTuple;
+    std::shared_ptr<EventHandler> getDispatch(size_t id);
 protected:
     boost::mutex mutex_;
-    std::unordered_map<size_t, std::vector<ListTuple>> plugin_;
-    std::unordered_map<size_t, std::unique_ptr<EventHandler>> handler_;
+    EventMetrics metrics_;
+    std::unordered_map<size_t, std::vector<Handle>> plugin_;
+    std::unordered_map<size_t, RegistrationList> handler_;
+    RegistrationIndex index_;
+    std::unordered_map<size_t, std::unique_ptr<DispatchCell>> dispatch_;
+    std::shared_ptr<const DispatchMap> snapshot_;
+    std::atomic<size_t> version_;
+    bool isDispatchChanged_;
+    std::unordered_map<size_t, size_t> parent_;
+    std::unordered_map<size_t, std::vector<size_t>> children_;
+    EventQueue queue_[EVENT_QUEUE_COUNT];
+    EventQueue lane_[EVENT_LANE_COUNT];
+    EventQueue posted_;
+    std::atomic<size_t> postedLength_;
 };
 
 }; // namespace Ghrum
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _EVENT_METRICS_HPP_
+#define _EVENT_METRICS_HPP_
+
+#include <Event/IEventManager.hpp>
+#include <atomic>
+#include <map>
+#include <memory>
+
+namespace Ghrum {
+
+/**
+ * Number of buckets of a histogram, the bucket N holds the calls
+ * that took between 2^N and 2^(N+1) nanoseconds.
+ */
+#define EVENT_METRICS_BUCKET 32
+
+/**
+ * Encapsulate the sampled latency of every delegate call, grouped by
+ * event id, priority and owner. The counters of a group are allocated
+ * when a dispatch handler is built, so recording a call never takes a
+ * lock nor looks for its group.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class EventMetrics {
+public:
+    /**
+     * Define the latency histogram of a group of delegates.
+     */
+    struct Histogram {
+        size_t id, owner;
+        EventPriority priority;
+        uint64_t count, total, maximum;
+        uint64_t buckets[EVENT_METRICS_BUCKET];
+    };
+
+    /**
+     * Define the counters of a group of delegates, updated by every
+     * worker without any lock.
+     */
+    struct Counter {
+        /**
+         * Default constructor of the counters.
+         *
+         * @param id the id of the event
+         * @param priority the priority of the delegates
+         * @param owner the id of the owner of the delegates
+         */
+        Counter(size_t id, EventPriority priority, size_t owner);
+
+        size_t id, owner;
+        EventPriority priority;
+        std::atomic<uint64_t> count, total, maximum;
+        std::atomic<uint64_t> buckets[EVENT_METRICS_BUCKET];
+    };
+public:
+    /**
+     * Default constructor of the metrics, disabled by default.
+     */
+    EventMetrics();
+
+    /**
+     * Return if the metrics are enabled.
+     */
+    bool isEnabled();
+
+    /**
+     * Sets if the metrics are enabled.
+     *
+     * @param isEnabled true to enable the metrics
+     */
+    void setEnabled(bool isEnabled);
+
+    /**
+     * Sets the sample rate of the metrics.
+     *
+     * @param rate the emits to skip between each sampled emit, 1 to sample every emit
+     */
+    void setSampleRate(size_t rate);
+
+    /**
+     * Return if the current emit must be sampled, called
+     * once for every emit. Every thread counts its own emits.
+     */
+    bool isSampled();
+
+    /**
+     * Return the counters of a group of delegates, creating them if
+     * needed. Called when a dispatch handler is built, the counters live
+     * as long as the metrics.
+     *
+     * @param id the id of the event
+     * @param priority the priority of the delegates
+     * @param owner the id of the owner of the delegates
+     */
+    Counter & getCounter(size_t id, EventPriority priority, size_t owner);
+
+    /**
+     * Record the latency of a delegate call, can be called from any
+     * thread.
+     *
+     * @param counter the counters of the delegate
+     * @param nanoseconds the latency of the call
+     */
+    static void record(Counter & counter, uint64_t nanoseconds);
+
+    /**
+     * Return a copy of every histogram recorded.
+     */
+    std::vector<Histogram> getHistograms();
+
+    /**
+     * Discard every latency recorded.
+     */
+    void reset();
+private:
+    /**
+     * A type definition of the key of each histogram.
+     */
+    typedef std::tuple<size_t, int, size_t> HistogramKey;
+protected:
+    std::atomic<bool> enabled_;
+    std::atomic<size_t> rate_;
+    boost::mutex mutex_;
+    std::map<HistogramKey, std::unique_ptr<Counter>> group_;
+};
+
+}; // namespace Ghrum
+
+#endif // _EVENT_METRICS_HPP_
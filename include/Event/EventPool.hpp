@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _EVENT_POOL_HPP_
+#define _EVENT_POOL_HPP_
+
+#include <boost/lockfree/stack.hpp>
+#include <atomic>
+#include <memory>
+
+namespace Ghrum {
+
+/**
+ * Number of blocks that a pool keeps for recycling.
+ */
+#define EVENT_POOL_CAPACITY 1024
+
+/**
+ * Encapsulate a lock-free pool of objects of the same type, used to
+ * recycle high frequency events instead of going to the heap.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+template<typename T>
+class EventPool {
+public:
+    /**
+     * Allocator that takes its blocks from the pool, the control block
+     * of a {@see std::shared_ptr} lives in the same block as the object.
+     */
+    template<typename U>
+    struct Allocator {
+        typedef U value_type;
+
+        template<typename V>
+        struct rebind {
+            typedef Allocator<V> other;
+        };
+
+        Allocator(EventPool<T> & pool)
+            : pool(&pool) {
+        }
+
+        template<typename V>
+        Allocator(const Allocator<V> & other)
+            : pool(other.pool) {
+        }
+
+        U * allocate(size_t n) {
+            return static_cast<U *>(pool->allocate(n * sizeof(U)));
+        }
+
+        void deallocate(U * block, size_t n) {
+            pool->deallocate(block, n * sizeof(U));
+        }
+
+        template<typename V>
+        bool operator==(const Allocator<V> & other) const {
+            return pool == other.pool;
+        }
+
+        template<typename V>
+        bool operator!=(const Allocator<V> & other) const {
+            return pool != other.pool;
+        }
+
+        EventPool<T> * pool;
+    };
+public:
+    /**
+     * Return the pool of the type, the pool is never destroyed since
+     * an event may outlive any static object.
+     */
+    static EventPool<T> & getInstance() {
+        static EventPool<T> * instance = new EventPool<T>(EVENT_POOL_CAPACITY);
+        return *instance;
+    }
+
+    /**
+     * Default constructor of the pool.
+     *
+     * @param capacity the number of blocks to keep for recycling
+     */
+    EventPool(size_t capacity)
+        : size_(0), free_(capacity) {
+    }
+
+    /**
+     * Destructor of the pool, release every recycled block.
+     */
+    ~EventPool() {
+        void * block;
+        while (free_.pop(block))
+            ::operator delete(block);
+    }
+
+    /**
+     * Construct a new object into a block of the pool, the block is given
+     * back when the last reference to the object is released.
+     *
+     * @param args the arguments of the object constructor
+     */
+    template<typename... Args>
+    std::shared_ptr<T> create(Args && ... args) {
+        return std::allocate_shared<T>(Allocator<T>(*this), std::forward<Args>(args)...);
+    }
+
+    /**
+     * Allocate a block from the pool.
+     *
+     * @param size the size of the block
+     */
+    void * allocate(size_t size) {
+        void * block;
+
+        // Every block of the pool has the size of the first allocation,
+        // which is the same for every allocation of the same type.
+        size_t expected = 0;
+        size_.compare_exchange_strong(expected, size);
+        if (size_ == size && free_.pop(block)) {
+            return block;
+        }
+        return ::operator new(size);
+    }
+
+    /**
+     * Give a block back to the pool.
+     *
+     * @param block the block to give back
+     * @param size the size of the block
+     */
+    void deallocate(void * block, size_t size) {
+        if (size_ != size || !free_.bounded_push(block)) {
+            ::operator delete(block);
+        }
+    }
+private:
+    std::atomic<size_t> size_;
+    boost::lockfree::stack<void *> free_;
+};
+
+}; // namespace Ghrum
+
+#endif // _EVENT_POOL_HPP_
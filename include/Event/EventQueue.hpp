@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _EVENT_QUEUE_HPP_
+#define _EVENT_QUEUE_HPP_
+
+#include "EventPool.hpp"
+#include <Event/IEventManager.hpp>
+#include <atomic>
+#include <vector>
+
+namespace Ghrum {
+
+/**
+ * Number of asynchronous queues, every event id is mapped
+ * always into the same queue.
+ */
+#define EVENT_QUEUE_COUNT 64
+
+/**
+ * Number of ordered lanes, every ordering key is mapped always
+ * into the same lane.
+ */
+#define EVENT_LANE_COUNT 64
+
+/**
+ * Number of entries a drain emits before it hands the rest of the
+ * queue to another task.
+ */
+#define EVENT_DRAIN_LENGTH 4096
+
+/**
+ * Number of events that can be waiting to be emitted in the main
+ * thread at the same time.
+ */
+#define EVENT_POST_CAPACITY 65536
+
+/**
+ * Encapsulate a lock-free multiple producer queue of asynchronous
+ * events, drained in batches by a single consumer at a time.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class EventQueue {
+public:
+    /**
+     * Define a pending asynchronous event.
+     */
+    struct Entry {
+        /**
+         * Default constructor of an entry.
+         *
+         * @param event the event to emit
+         * @param id the id of the event
+         */
+        Entry(std::shared_ptr<Event> event, size_t id);
+
+        /**
+         * Take the memory of the entry from the entry's pool.
+         */
+        static void * operator new(size_t size);
+
+        /**
+         * Give the memory of the entry back to the entry's pool.
+         */
+        static void operator delete(void * block, size_t size);
+
+        std::shared_ptr<Event> event;
+        IEventManager::EventDelegate function;
+        size_t id, key, route, order;
+        bool isCoalesced, isCompletion, isRouted, isOrdered;
+        Entry * next;
+    };
+private:
+    /**
+     * Define a coalesced key seen by the current drain, slots of an older
+     * drain are free.
+     */
+    struct Coalesced {
+        size_t id, key, drain;
+    };
+public:
+    /**
+     * Default constructor of the queue.
+     */
+    EventQueue();
+
+    /**
+     * Destructor of the queue, every pending entry is discarded.
+     */
+    ~EventQueue();
+
+    /**
+     * Push an entry into the queue.
+     *
+     * @param entry the entry to push
+     * @return true if the caller must schedule a drain of the queue
+     */
+    bool push(Entry * entry);
+
+    /**
+     * Pop every pending entry of the queue, in the order they were
+     * pushed, keeping only the latest entry of each coalesced key.
+     *
+     * @return the first entry of the batch or nullptr
+     */
+    Entry * pop();
+
+    /**
+     * Release the drain of the queue.
+     *
+     * @return true if the caller must drain the queue again
+     */
+    bool release();
+
+    /**
+     * Mix the bits of a key, so keys that only differ in their high bits
+     * are spread as well as any other.
+     *
+     * @param value the key to mix
+     */
+    static size_t mix(uint64_t value);
+private:
+    /**
+     * Mark a coalesced key as seen by the current drain.
+     *
+     * @return true if the key wasn't seen yet
+     */
+    bool insertCoalesced(size_t id, size_t key);
+private:
+    std::atomic<Entry *> head_;
+    std::atomic<bool> scheduled_;
+    size_t drain_, coalescedLength_;
+    std::vector<Coalesced> coalesced_;
+};
+
+}; // namespace Ghrum
+
+#endif // _EVENT_QUEUE_HPP_
@@ -17,6 +17,7 @@
 #define _GHRUM_ENGINE_SERVER_HPP_
 
 #include "GhrumEngine.hpp"
+#include "Network/SessionManager.hpp"
 
 namespace Ghrum {
 
@@ -41,6 +42,13 @@ public:
      * {@inheritDoc}
      */
     Platform getPlatform();
+
+    /**
+     * Return the manager of the network sessions.
+     */
+    SessionManager & getSessionManager();
+protected:
+    std::unique_ptr<SessionManager> sessionManager_;
 };
 
 } // namespace Ghrum
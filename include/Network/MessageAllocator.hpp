@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _MESSAGE_ALLOCATOR_HPP_
+#define _MESSAGE_ALLOCATOR_HPP_
+
+#include <Types.hpp>
+#include <boost/lockfree/stack.hpp>
+#include <atomic>
+#include <memory>
+
+namespace Ghrum {
+
+/**
+ * Size of the smallest class of blocks, in bytes, every class doubles
+ * the size of the previous one.
+ */
+#define MESSAGE_ALLOCATOR_MINIMUM 4096
+
+/**
+ * Number of classes of blocks, from 4 KiB to 4 MiB. Larger blocks are
+ * taken from the heap and never recycled.
+ */
+#define MESSAGE_ALLOCATOR_CLASSES 11
+
+/**
+ * Number of bytes of each class that a thread keeps for itself, a class
+ * of larger blocks isn't kept by the threads.
+ */
+#define MESSAGE_ALLOCATOR_CACHE 1048576
+
+/**
+ * Number of bytes of each class that the threads share once their own
+ * caches are full.
+ */
+#define MESSAGE_ALLOCATOR_SHARED 16777216
+
+/**
+ * Number of bytes the allocator can hold at the same time, the blocks
+ * in use by the buffers and the free blocks kept for them alike. An
+ * allocation past it fails.
+ */
+#define MESSAGE_ALLOCATOR_LIMIT 1073741824
+
+/**
+ * Encapsulate the memory of every message buffer, split into classes of
+ * power of two sizes. Each thread, and so each reactor, keeps a cache of
+ * free blocks of every class and only goes to the shared pool of the
+ * class when its cache is empty or full, and to the heap when the shared
+ * pool is empty or full.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class MessageAllocator {
+public:
+    /**
+     * Define the usage of the allocator.
+     */
+    struct Statistics {
+        uint64_t hits, misses, failures;
+        size_t used, held, peak, limit;
+    };
+public:
+    /**
+     * Return the allocator of the process, the allocator is never destroyed
+     * since a buffer may outlive any static object.
+     */
+    static MessageAllocator & getInstance();
+
+    /**
+     * Default constructor of the allocator.
+     *
+     * @param limit the number of bytes that can be held at the same time
+     */
+    MessageAllocator(size_t limit);
+
+    /**
+     * Destructor of the allocator, release every shared block.
+     */
+    ~MessageAllocator();
+
+    /**
+     * Allocate a block.
+     *
+     * @param capacity the minimum size of the block, rounded up to the size
+     *                 of its class
+     * @return the block
+     * @throws std::bad_alloc if the limit would be exceeded even without
+     *         the free blocks of the shared pool
+     */
+    int8_t * allocate(size_t & capacity);
+
+    /**
+     * Give a block back.
+     *
+     * @param block the block to give back
+     * @param capacity the size of the block
+     */
+    void deallocate(int8_t * block, size_t capacity);
+
+    /**
+     * Return the usage of the allocator.
+     */
+    Statistics getStatistics();
+
+    /**
+     * Sets the number of bytes that can be held at the same time, the
+     * blocks already held are kept.
+     *
+     * @param limit the number of bytes
+     */
+    void setLimit(size_t limit);
+private:
+    /**
+     * Return the class of a block size, or MESSAGE_ALLOCATOR_CLASSES when
+     * the size is larger than every class.
+     */
+    static size_t getClass(size_t capacity);
+
+    /**
+     * Encapsulate the free blocks of a thread.
+     */
+    struct Cache;
+
+    /**
+     * Return the cache of the current thread, or nullptr if the thread
+     * doesn't cache the blocks of the allocator.
+     */
+    Cache * getCache();
+
+    /**
+     * Take a block of a class from the shared pool or the heap.
+     */
+    int8_t * doAllocate(size_t index, size_t size);
+
+    /**
+     * Give a block of a class to the shared pool or the heap.
+     */
+    void doDeallocate(int8_t * block, size_t index, size_t size);
+
+    /**
+     * Take bytes from the heap against the limit, giving the free blocks
+     * of the shared pool back to the heap when it would be exceeded.
+     *
+     * @return true if the bytes were taken
+     */
+    bool doReserve(size_t size);
+protected:
+    std::atomic<size_t> used_, held_, peak_, limit_;
+    std::atomic<uint64_t> hits_, misses_, failures_;
+    std::unique_ptr<boost::lockfree::stack<int8_t *>> shared_[MESSAGE_ALLOCATOR_CLASSES];
+};
+
+}; // namespace Ghrum
+
+#endif // _MESSAGE_ALLOCATOR_HPP_
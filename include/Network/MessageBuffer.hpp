@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _MESSAGE_BUFFER_HPP_
+#define _MESSAGE_BUFFER_HPP_
+
+#include <Types.hpp>
+
+namespace Ghrum {
+
+/**
+ * Default capacity of a buffer, in bytes.
+ */
+#define MESSAGE_BUFFER_CAPACITY 4096
+
+/**
+ * Encapsulate a contiguous buffer of bytes, written at the end and read
+ * from the front. The unread bytes are always contiguous, so they can be
+ * decoded in place and handed to the socket without any copy. The memory
+ * of the buffer is taken from {@see MessageAllocator}.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class MessageBuffer {
+public:
+    /**
+     * Default constructor of the buffer.
+     *
+     * @param capacity the initial capacity of the buffer
+     */
+    MessageBuffer(size_t capacity = MESSAGE_BUFFER_CAPACITY);
+
+    /**
+     * Move constructor of the buffer.
+     *
+     * @param other the buffer to take the bytes from
+     */
+    MessageBuffer(MessageBuffer && other);
+
+    /**
+     * Destructor of the buffer, give its memory back to the allocator.
+     */
+    ~MessageBuffer();
+
+    /**
+     * Move assignment of the buffer.
+     *
+     * @param other the buffer to take the bytes from
+     */
+    MessageBuffer & operator=(MessageBuffer && other);
+
+    /**
+     * Return the first unread byte of the buffer.
+     */
+    int8_t * getData() {
+        return data_ + read_;
+    }
+
+    /**
+     * Return the first unread byte of the buffer.
+     */
+    const int8_t * getData() const {
+        return data_ + read_;
+    }
+
+    /**
+     * Return the number of unread bytes of the buffer.
+     */
+    size_t getLength() const {
+        return write_ - read_;
+    }
+
+    /**
+     * Return the number of bytes the buffer can hold without growing.
+     */
+    size_t getCapacity() const {
+        return capacity_;
+    }
+
+    /**
+     * Return room for the given number of bytes at the end of the
+     * buffer, the bytes become readable once committed.
+     *
+     * @param length the number of bytes to make room for
+     * @return the first byte of the room
+     */
+    int8_t * prepare(size_t length);
+
+    /**
+     * Make readable the given number of bytes written into the room
+     * returned by {@see MessageBuffer::prepare}.
+     *
+     * @param length the number of bytes written
+     */
+    void commit(size_t length) {
+        write_ += length;
+    }
+
+    /**
+     * Append a copy of the given bytes to the buffer.
+     *
+     * @param data the bytes to append
+     * @param length the number of bytes to append
+     */
+    void write(const int8_t * data, size_t length);
+
+    /**
+     * Discard the given number of bytes from the front of the buffer,
+     * which must not be more than the unread bytes.
+     *
+     * @param length the number of bytes to discard
+     */
+    void consume(size_t length) {
+        read_ += length;
+        if (read_ == write_) {
+            read_ = write_ = 0;
+        }
+    }
+
+    /**
+     * Discard every byte of the buffer, keeping its capacity.
+     */
+    void clear();
+private:
+    MessageBuffer(const MessageBuffer &);
+    MessageBuffer & operator=(const MessageBuffer &);
+private:
+    int8_t * data_;
+    size_t capacity_, read_, write_;
+};
+
+} // namespace Ghrum
+
+#endif // _MESSAGE_BUFFER_HPP_
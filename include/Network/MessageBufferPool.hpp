@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _MESSAGE_BUFFER_POOL_HPP_
+#define _MESSAGE_BUFFER_POOL_HPP_
+
+#include "MessageBuffer.hpp"
+#include <boost/lockfree/stack.hpp>
+#include <memory>
+
+namespace Ghrum {
+
+/**
+ * Number of buffers that the pool keeps for recycling.
+ */
+#define MESSAGE_BUFFER_POOL_CAPACITY 1024
+
+/**
+ * Capacity above which a buffer is not recycled, so a single large
+ * message doesn't pin its memory forever.
+ */
+#define MESSAGE_BUFFER_POOL_LIMIT 65536
+
+/**
+ * Encapsulate a lock-free pool of message buffers, a buffer keeps its
+ * capacity while it is in the pool.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class MessageBufferPool {
+public:
+    /**
+     * Return the pool of the process, the pool is never destroyed since
+     * a buffer may outlive any static object.
+     */
+    static MessageBufferPool & getInstance();
+
+    /**
+     * Default constructor of the pool.
+     *
+     * @param capacity the number of buffers to keep for recycling
+     */
+    MessageBufferPool(size_t capacity);
+
+    /**
+     * Destructor of the pool, release every recycled buffer.
+     */
+    ~MessageBufferPool();
+
+    /**
+     * Take an empty buffer from the pool.
+     */
+    MessageBuffer * acquire();
+
+    /**
+     * Give a buffer back to the pool.
+     *
+     * @param buffer the buffer to give back
+     */
+    void release(MessageBuffer * buffer);
+
+    /**
+     * Turn a buffer taken from the pool into an immutable buffer that
+     * can be shared by many sessions, it is given back to the pool
+     * once the last reference is dropped.
+     *
+     * @param buffer the buffer to share
+     * @return the shared buffer
+     */
+    std::shared_ptr<const MessageBuffer> share(MessageBuffer * buffer);
+private:
+    boost::lockfree::stack<MessageBuffer *> free_;
+};
+
+} // namespace Ghrum
+
+#endif // _MESSAGE_BUFFER_POOL_HPP_
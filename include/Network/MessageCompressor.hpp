@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _MESSAGE_COMPRESSOR_HPP_
+#define _MESSAGE_COMPRESSOR_HPP_
+
+#include <Types.hpp>
+#include <memory>
+
+struct z_stream_s;
+
+namespace Ghrum {
+
+/**
+ * Default number of bytes from which the body of a frame is compressed.
+ */
+#define MESSAGE_COMPRESSION_THRESHOLD 256
+
+/**
+ * Level of the zlib compression, a trade between speed and ratio.
+ */
+#define MESSAGE_COMPRESSION_ZLIB_LEVEL 6
+
+/**
+ * Enumeration of the algorithms a frame can be compressed with.
+ */
+enum class MessageCompression {
+    None,
+    Zlib,
+    Lz4
+};
+
+/**
+ * Encapsulate the compression contexts of a thread, they are set up once
+ * and reset for every message.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class MessageCompressor {
+public:
+    /**
+     * Return the compressor of the calling thread.
+     */
+    static MessageCompressor & getInstance();
+
+    /**
+     * Return if an algorithm is available in this build.
+     *
+     * @param compression the algorithm
+     */
+    static bool isSupported(MessageCompression compression);
+
+    /**
+     * Destructor of the compressor, releases every context.
+     */
+    ~MessageCompressor();
+
+    /**
+     * Return the maximum number of bytes a message can take once compressed.
+     *
+     * @param compression the algorithm
+     * @param length the number of bytes of the message
+     */
+    size_t getBound(MessageCompression compression, size_t length);
+
+    /**
+     * Compress a message.
+     *
+     * @param compression the algorithm
+     * @param data the bytes of the message
+     * @param length the number of bytes of the message
+     * @param output where to write, with room for {@see MessageCompressor::getBound} bytes
+     * @return the number of bytes written
+     */
+    size_t compress(MessageCompression compression, const int8_t * data, size_t length, int8_t * output);
+
+    /**
+     * Decompress a message, which must have the exact given length.
+     *
+     * @param compression the algorithm
+     * @param data the compressed bytes
+     * @param length the number of compressed bytes
+     * @param output where to write the message
+     * @param size the number of bytes of the message
+     * @throws std::runtime_error if the bytes are malformed
+     */
+    void decompress(MessageCompression compression, const int8_t * data, size_t length, int8_t * output,
+                    size_t size);
+private:
+    /**
+     * Default constructor of the compressor.
+     */
+    MessageCompressor();
+
+    MessageCompressor(const MessageCompressor &);
+    MessageCompressor & operator=(const MessageCompressor &);
+private:
+    std::unique_ptr<z_stream_s> deflate_, inflate_;
+    std::unique_ptr<char[]> lz4_;
+};
+
+}; // namespace Ghrum
+
+#endif // _MESSAGE_COMPRESSOR_HPP_
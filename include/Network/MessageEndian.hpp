@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _MESSAGE_ENDIAN_HPP_
+#define _MESSAGE_ENDIAN_HPP_
+
+#include <Types.hpp>
+
+namespace Ghrum {
+
+/**
+ * Define if the host stores values in big endian order.
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define MESSAGE_HOST_BIG_ENDIAN true
+#else
+#define MESSAGE_HOST_BIG_ENDIAN false
+#endif
+
+/**
+ * Reverse the bytes of a fixed width value, each overload compiles
+ * into a single instruction.
+ */
+inline uint8_t swapBytes(uint8_t value) {
+    return value;
+}
+
+inline uint16_t swapBytes(uint16_t value) {
+    return __builtin_bswap16(value);
+}
+
+inline uint32_t swapBytes(uint32_t value) {
+    return __builtin_bswap32(value);
+}
+
+inline uint64_t swapBytes(uint64_t value) {
+    return __builtin_bswap64(value);
+}
+
+/**
+ * Copy an array of fixed width values reversing the bytes of each value,
+ * using the widest vector kernel the CPU supports. Neither array needs
+ * to be aligned.
+ *
+ * @param destination where to copy the values
+ * @param source the values to copy
+ * @param count the number of values
+ * @param width the width of each value, 2, 4 or 8 bytes
+ */
+void copySwapped(void * destination, const void * source, size_t count, size_t width);
+
+} // namespace Ghrum
+
+#endif // _MESSAGE_ENDIAN_HPP_
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _MESSAGE_FRAME_PARSER_HPP_
+#define _MESSAGE_FRAME_PARSER_HPP_
+
+#include <Types.hpp>
+
+namespace Ghrum {
+
+/**
+ * Default maximum length of the body of a frame, in bytes.
+ */
+#define MESSAGE_FRAME_LIMIT 2097152
+
+/**
+ * Maximum number of bytes of the prefix of a frame.
+ */
+#define MESSAGE_FRAME_PREFIX_LENGTH 5
+
+/**
+ * Enumeration of the prefixes that can precede the body of a frame.
+ */
+enum class MessageFramePrefix {
+    None,
+    Short,
+    Integer,
+    Varint
+};
+
+/**
+ * Encapsulate the parsing of length prefixed frames, the frames are
+ * found in place and never copied.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class MessageFrameParser {
+public:
+    /**
+     * Default constructor of the parser.
+     *
+     * @param prefix the prefix of every frame
+     * @param isBigEndianness if fixed width prefixes are big endian
+     * @param limit the maximum length of the body of a frame
+     */
+    MessageFrameParser(MessageFramePrefix prefix = MessageFramePrefix::None, bool isBigEndianness = false,
+                       size_t limit = MESSAGE_FRAME_LIMIT);
+
+    /**
+     * Return the prefix of every frame.
+     */
+    MessageFramePrefix getPrefix() const;
+
+    /**
+     * Return if fixed width prefixes are big endian.
+     */
+    bool isBigEndianness() const;
+
+    /**
+     * Return the maximum length of the body of a frame.
+     */
+    size_t getLimit() const;
+
+    /**
+     * Find the frame at the front of the given bytes, without a prefix
+     * every byte given is a single frame.
+     *
+     * @param data the bytes received
+     * @param length the number of bytes received
+     * @param offset where to save the offset of the body of the frame
+     * @param size where to save the length of the body of the frame
+     * @return true if the frame is complete, false if more bytes are needed
+     * @throws std::length_error if the frame is longer than the limit
+     */
+    bool next(const int8_t * data, size_t length, size_t & offset, size_t & size) const;
+
+    /**
+     * Write the prefix of a frame, the opposite of {@see MessageFrameParser::next}.
+     *
+     * @param data where to write, with room for MESSAGE_FRAME_PREFIX_LENGTH bytes
+     * @param size the length of the body of the frame
+     * @return the number of bytes written
+     * @throws std::length_error if the prefix can't hold the length
+     */
+    size_t encode(int8_t * data, size_t size) const;
+private:
+    MessageFramePrefix prefix_;
+    bool isBigEndianness_;
+    size_t limit_;
+};
+
+}; // namespace Ghrum
+
+#endif // _MESSAGE_FRAME_PARSER_HPP_
@@ -16,8 +16,11 @@
 #ifndef _MESSAGE_INPUT_STREAM_HPP_
 #define _MESSAGE_INPUT_STREAM_HPP_
 
+#include "MessageBuffer.hpp"
 #include <Network/IMessageInputStream.hpp>
+#include <boost/utility/string_ref.hpp>
 #include <deque>
+#include <stdexcept>
 
 namespace Ghrum {
 
@@ -29,11 +32,27 @@ namespace Ghrum {
 class MessageInputStream : public IMessageInputStream {
 public:
     /**
-     * Default constructor of a input stream.
+     * Default constructor of a input stream, the bytes read are
+     * consumed from the buffer when the stream is destroyed, and the
+     * buffer must not change meanwhile.
      *
      * @param buffer where the data is at.
      */
-    MessageInputStream(std::deque<int8_t> & buffer);
+    MessageInputStream(MessageBuffer & buffer);
+
+    /**
+     * Constructor of a input stream bounded to bytes owned by someone
+     * else, which must outlive the stream.
+     *
+     * @param data the first byte of the stream
+     * @param length the number of bytes of the stream
+     */
+    MessageInputStream(const int8_t * data, size_t length);
+
+    /**
+     * Destructor of the input stream.
+     */
+    ~MessageInputStream();
 
     /**
      * {@inheritDoc}
@@ -105,6 +124,118 @@ public:
      */
     std::u16string readUnicode();
 
+    /**
+     * Read a string written by {@see MessageOutputStream::writeString}
+     * without copying it. The view points into the bytes of the stream,
+     * so it is only valid while they are.
+     *
+     * @return the string read
+     */
+    boost::string_ref readStringView();
+
+    /**
+     * Read a unicode string written by {@see MessageOutputStream::writeUnicode}
+     * transcoded into UTF-8. The string given keeps its capacity, so reading
+     * into the same string many times doesn't allocate.
+     *
+     * @param value where to save the string
+     */
+    void readUnicode(std::string & value);
+
+    /**
+     * Read an unsigned integer written as a varint, from 1 to 5 bytes.
+     *
+     * @return the value read
+     */
+    uint32_t readVarUnsignedInteger();
+
+    /**
+     * Read an integer written as a zigzag varint, from 1 to 5 bytes.
+     *
+     * @return the value read
+     */
+    int32_t readVarInteger();
+
+    /**
+     * Read an unsigned long written as a varint, from 1 to 10 bytes.
+     *
+     * @return the value read
+     */
+    uint64_t readVarUnsignedLong();
+
+    /**
+     * Read a long written as a zigzag varint, from 1 to 10 bytes.
+     *
+     * @return the value read
+     */
+    int64_t readVarLong();
+
+    /**
+     * Read a string prefixed by its length as a varint.
+     *
+     * @return the string read
+     */
+    std::string readVarString();
+
+    /**
+     * Read a string prefixed by its length as a varint without copying it.
+     * The view points into the bytes of the stream, so it is only valid
+     * while they are.
+     *
+     * @return the string read
+     */
+    boost::string_ref readVarStringView();
+
+    /**
+     * Read an array of shorts in a single pass.
+     *
+     * @param buffer where to save the values
+     * @param length the number of values to read
+     * @return the number of values read
+     * @throws std::out_of_range if the stream doesn't have enough bytes
+     */
+    size_t readShortArray(int16_t * buffer, size_t length);
+
+    /**
+     * Read an array of integers in a single pass.
+     *
+     * @param buffer where to save the values
+     * @param length the number of values to read
+     * @return the number of values read
+     * @throws std::out_of_range if the stream doesn't have enough bytes
+     */
+    size_t readIntegerArray(int32_t * buffer, size_t length);
+
+    /**
+     * Read an array of longs in a single pass.
+     *
+     * @param buffer where to save the values
+     * @param length the number of values to read
+     * @return the number of values read
+     * @throws std::out_of_range if the stream doesn't have enough bytes
+     */
+    size_t readLongArray(int64_t * buffer, size_t length);
+
+    /**
+     * Read an array of floats in a single pass.
+     *
+     * @param buffer where to save the values
+     * @param length the number of values to read
+     * @return the number of values read
+     * @throws std::out_of_range if the stream doesn't have enough bytes
+     */
+    size_t readFloatArray(float * buffer, size_t length);
+
+    /**
+     * Read an array of doubles in a single pass.
+     *
+     * @param buffer where to save the values
+     * @param length the number of values to read
+     * @return the number of values read
+     * @throws std::out_of_range if the stream doesn't have enough bytes
+     */
+    size_t readDoubleArray(double * buffer, size_t length);
+
     /**
      * {@inheritDoc}
      */
@@ -120,13 +251,65 @@ public:
      */
     void setEndianness(bool isBigEndianness);
 
+    /**
+     * Return if the stream reads values in big endian order.
+     */
+    bool isBigEndianness() const {
+        return isBigEndianness_;
+    }
+
+    /**
+     * Take bytes from the stream at once, so many fixed width values can
+     * be decoded in place with a single check.
+     *
+     * @param length the number of bytes to take
+     * @return the first byte taken
+     * @throws std::out_of_range if the stream doesn't have enough bytes
+     */
+    const int8_t * readRaw(size_t length) {
+        if (size_t(limit_ - position_) < length) {
+            throw std::out_of_range("Not enough bytes to read from the stream");
+        }
+        const int8_t * data = position_;
+        position_ += length;
+        return data;
+    }
+
     /**
      * {@inheritDoc}
+     *
+     * The stream doesn't read from a deque, the deque returned is a copy
+     * of the unread bytes and changing it doesn't change the stream.
      */
     std::deque<int8_t> & getBuffer();
+private:
+    /**
+     * Read a fixed width value with a single load, swapping its bytes
+     * when the endianness of the stream isn't the one of the host.
+     */
+    template<typename T>
+    T readValue();
+
+    /**
+     * Read a varint of the width of the type.
+     */
+    template<typename T>
+    T readVarint();
+
+    /**
+     * Read an array of fixed width values, swapping the bytes of
+     * every value when needed.
+     */
+    template<typename T>
+    size_t readArray(T * buffer, size_t length);
+private:
+    MessageInputStream(const MessageInputStream &);
+    MessageInputStream & operator=(const MessageInputStream &);
 private:
     bool isBigEndianness_;
-    std::deque<int8_t> & buffer_;
+    MessageBuffer * buffer_;
+    const int8_t * start_, * position_, * limit_;
+    std::deque<int8_t> copy_;
 };
 
 } // namespace Ghrum
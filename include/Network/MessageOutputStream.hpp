@@ -16,10 +16,293 @@
 #ifndef _MESSAGE_OUTPUT_STREAM_HPP_
 #define _MESSAGE_OUTPUT_STREAM_HPP_
 
+#include "MessageBuffer.hpp"
 #include <Network/IMessageOutputStream.hpp>
+#include <memory>
 
 namespace Ghrum {
 
+/**
+ * Implementation of {@see IMessageOutputStream}.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class MessageOutputStream : public IMessageOutputStream {
+public:
+    /**
+     * Default constructor of a output stream, the stream writes into a
+     * buffer of the buffer pool that is given back on destruction.
+     */
+    MessageOutputStream();
+
+    /**
+     * Constructor of a output stream that appends to a buffer.
+     *
+     * @param buffer where the data is written.
+     */
+    MessageOutputStream(MessageBuffer & buffer);
+
+    /**
+     * Destructor of the output stream.
+     */
+    ~MessageOutputStream();
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeBoolean(bool value);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeByte(int8_t value);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeBytes(const int8_t * buffer, size_t length);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeUnsignedByte(uint8_t value);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeShort(int16_t value);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeUnsignedShort(uint16_t value);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeInteger(int32_t value);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeUnsignedInteger(uint32_t value);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeLong(int64_t value);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeUnsignedLong(uint64_t value);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeFloat(float value);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeDouble(double value);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeString(const std::string & value);
+
+    /**
+     * {@inheritDoc}
+     */
+    void writeUnicode(const std::u16string & value);
+
+    /**
+     * Write an unsigned integer as a varint, from 1 to 5 bytes.
+     *
+     * @param value the value to write
+     */
+    void writeVarUnsignedInteger(uint32_t value);
+
+    /**
+     * Write an integer as a zigzag varint, from 1 to 5 bytes.
+     *
+     * @param value the value to write
+     */
+    void writeVarInteger(int32_t value);
+
+    /**
+     * Write an unsigned long as a varint, from 1 to 10 bytes.
+     *
+     * @param value the value to write
+     */
+    void writeVarUnsignedLong(uint64_t value);
+
+    /**
+     * Write a long as a zigzag varint, from 1 to 10 bytes.
+     *
+     * @param value the value to write
+     */
+    void writeVarLong(int64_t value);
+
+    /**
+     * Write a string prefixed by its length as a varint.
+     *
+     * @param value the string to write
+     */
+    void writeVarString(const std::string & value);
+
+    /**
+     * Write an array of shorts in a single pass.
+     *
+     * @param buffer the values to write
+     * @param length the number of values to write
+     */
+    void writeShortArray(const int16_t * buffer, size_t length);
+
+    /**
+     * Write an array of integers in a single pass.
+     *
+     * @param buffer the values to write
+     * @param length the number of values to write
+     */
+    void writeIntegerArray(const int32_t * buffer, size_t length);
+
+    /**
+     * Write an array of longs in a single pass.
+     *
+     * @param buffer the values to write
+     * @param length the number of values to write
+     */
+    void writeLongArray(const int64_t * buffer, size_t length);
+
+    /**
+     * Write an array of floats in a single pass.
+     *
+     * @param buffer the values to write
+     * @param length the number of values to write
+     */
+    void writeFloatArray(const float * buffer, size_t length);
+
+    /**
+     * Write an array of doubles in a single pass.
+     *
+     * @param buffer the values to write
+     * @param length the number of values to write
+     */
+    void writeDoubleArray(const double * buffer, size_t length);
+
+    /**
+     * {@inheritDoc}
+     */
+    size_t getLength();
+
+    /**
+     * {@inheritDoc}
+     */
+    void setEndianness(bool isBigEndianness);
+
+    /**
+     * Return if the stream writes values in big endian order.
+     */
+    bool isBigEndianness() const {
+        return isBigEndianness_;
+    }
+
+    /**
+     * Append bytes to the stream at once, so many fixed width values can
+     * be encoded in place with a single check.
+     *
+     * @param length the number of bytes to append
+     * @return the first byte appended, to be written by the caller
+     */
+    int8_t * writeRaw(size_t length) {
+        int8_t * data = buffer_->prepare(length);
+        buffer_->commit(length);
+        return data;
+    }
+
+    /**
+     * Reserve space for a value that is written later, such as the length
+     * prefix of a message.
+     *
+     * @param length the number of bytes to reserve
+     * @return the position of the reserved bytes
+     */
+    size_t reserve(size_t length);
+
+    /**
+     * Overwrite a byte written before.
+     *
+     * @param position the position of the byte
+     * @param value the value to write
+     */
+    void patchUnsignedByte(size_t position, uint8_t value);
+
+    /**
+     * Overwrite a short written before.
+     *
+     * @param position the position of the short
+     * @param value the value to write
+     */
+    void patchUnsignedShort(size_t position, uint16_t value);
+
+    /**
+     * Overwrite an integer written before.
+     *
+     * @param position the position of the integer
+     * @param value the value to write
+     */
+    void patchUnsignedInteger(size_t position, uint32_t value);
+
+    /**
+     * Return the buffer where the data is written.
+     */
+    MessageBuffer & getMessageBuffer();
+
+    /**
+     * Return every byte written into the stream as an immutable buffer,
+     * so a message encoded once can be sent to many sessions. A pooled
+     * stream hands its buffer over and starts again empty, otherwise the
+     * bytes are copied.
+     *
+     * @return the shared buffer
+     */
+    std::shared_ptr<const MessageBuffer> share();
+private:
+    /**
+     * Write a fixed width value with a single store, swapping its bytes
+     * when the endianness of the stream isn't the one of the host.
+     */
+    template<typename T>
+    void writeValue(T value);
+
+    /**
+     * Write a value as a varint.
+     */
+    template<typename T>
+    void writeVarint(T value);
+
+    /**
+     * Write an array of fixed width values, swapping the bytes of
+     * every value when needed.
+     */
+    template<typename T>
+    void writeArray(const T * buffer, size_t length);
+
+    /**
+     * Overwrite a fixed width value written before.
+     */
+    template<typename T>
+    void patchValue(size_t position, T value);
+private:
+    MessageOutputStream(const MessageOutputStream &);
+    MessageOutputStream & operator=(const MessageOutputStream &);
+private:
+    bool isBigEndianness_, isPooled_;
+    MessageBuffer * buffer_;
+};
+
 } // namespace Ghrum
 
 #endif // _MESSAGE_OUTPUT_STREAM_HPP_
@@ -0,0 +1,479 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _MESSAGE_SCHEMA_HPP_
+#define _MESSAGE_SCHEMA_HPP_
+
+#include "MessageInputStream.hpp"
+#include "MessageOutputStream.hpp"
+#include "MessageEndian.hpp"
+#include "MessageVarint.hpp"
+#include <type_traits>
+#include <vector>
+
+namespace Ghrum {
+
+/**
+ * Declare a field of a message, encoded with the default codec of its type.
+ */
+#define MESSAGE_FIELD(Class, Member) \
+    Ghrum::MessageField<Class, decltype(Class::Member), &Class::Member>
+
+/**
+ * Declare an integer field of a message, encoded as a varint, or as a
+ * zigzag varint when the integer is signed.
+ */
+#define MESSAGE_VARINT_FIELD(Class, Member) \
+    Ghrum::MessageField<Class, decltype(Class::Member), &Class::Member, \
+                        Ghrum::MessageVarintCodec<decltype(Class::Member)>>
+
+/**
+ * Define the unsigned integer with the width of a fixed width value.
+ */
+template<size_t Width>
+struct MessageWord;
+
+template<>
+struct MessageWord<1> {
+    typedef uint8_t type;
+};
+
+template<>
+struct MessageWord<2> {
+    typedef uint16_t type;
+};
+
+template<>
+struct MessageWord<4> {
+    typedef uint32_t type;
+};
+
+template<>
+struct MessageWord<8> {
+    typedef uint64_t type;
+};
+
+/**
+ * Define how a value is encoded. A codec with a size is fixed width and is
+ * loaded and stored in place, otherwise it reads and writes the stream.
+ *
+ * The default codec is the one of a nested message, which must declare its
+ * own schema.
+ */
+template<typename T, typename Enable = void>
+struct MessageCodec {
+    static const size_t size = 0;
+
+    static void read(MessageInputStream & stream, T & value) {
+        T::Schema::decode(stream, value);
+    }
+
+    static void write(MessageOutputStream & stream, const T & value) {
+        T::Schema::encode(stream, value);
+    }
+};
+
+/**
+ * Codec of a number, fixed width in the endianness of the stream.
+ */
+template<typename T>
+struct MessageCodec<T, typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+    typedef typename MessageWord<sizeof(T)>::type Word;
+
+    static const size_t size = sizeof(T);
+
+    static void load(const int8_t * data, bool isSwapped, T & value) {
+        Word word;
+        std::memcpy(&word, data, sizeof(word));
+        if (isSwapped) {
+            word = swapBytes(word);
+        }
+        std::memcpy(&value, &word, sizeof(value));
+    }
+
+    static void store(int8_t * data, bool isSwapped, const T & value) {
+        Word word;
+        std::memcpy(&word, &value, sizeof(word));
+        if (isSwapped) {
+            word = swapBytes(word);
+        }
+        std::memcpy(data, &word, sizeof(word));
+    }
+};
+
+/**
+ * Codec of a boolean, a single byte.
+ */
+template<>
+struct MessageCodec<bool> {
+    static const size_t size = 1;
+
+    static void load(const int8_t * data, bool, bool & value) {
+        value = (data[0] == 1);
+    }
+
+    static void store(int8_t * data, bool, const bool & value) {
+        data[0] = (value ? 1 : 0);
+    }
+};
+
+/**
+ * Codec of a string, prefixed by its length as a varint.
+ */
+template<>
+struct MessageCodec<std::string> {
+    static const size_t size = 0;
+
+    static void read(MessageInputStream & stream, std::string & value) {
+        value = stream.readVarString();
+    }
+
+    static void write(MessageOutputStream & stream, const std::string & value) {
+        stream.writeVarString(value);
+    }
+};
+
+/**
+ * Codec of a string view, encoded as a string. A decoded view points into
+ * the bytes of the stream, so it is only valid while they are.
+ */
+template<>
+struct MessageCodec<boost::string_ref> {
+    static const size_t size = 0;
+
+    static void read(MessageInputStream & stream, boost::string_ref & value) {
+        value = stream.readVarStringView();
+    }
+
+    static void write(MessageOutputStream & stream, const boost::string_ref & value) {
+        stream.writeVarUnsignedLong(value.size());
+        std::memcpy(stream.writeRaw(value.size()), value.data(), value.size());
+    }
+};
+
+/**
+ * Codec of a list, prefixed by its number of elements as a varint. A list of
+ * fixed width elements is read and written with a single check.
+ */
+template<typename T>
+struct MessageCodec<std::vector<T>> {
+    static_assert(!std::is_same<T, bool>::value, "A list of booleans isn't supported");
+
+    typedef MessageCodec<T> Element;
+
+    typedef std::integral_constant<bool, (Element::size > 0)> IsFixed;
+
+    typedef std::integral_constant<bool, std::is_arithmetic<T>::value> IsNumber;
+
+    static const size_t size = 0;
+
+    static void read(MessageInputStream & stream, std::vector<T> & value) {
+        // Every element takes at least a byte, so a bogus count fails
+        // before anything is allocated.
+        uint32_t count = stream.readVarUnsignedInteger();
+        if (count > stream.getLength() / (Element::size > 0 ? Element::size : 1)) {
+            throw std::out_of_range("Not enough bytes to read from the stream");
+        }
+        value.resize(count);
+        read(stream, value, IsFixed());
+    }
+
+    static void write(MessageOutputStream & stream, const std::vector<T> & value) {
+        stream.writeVarUnsignedInteger(uint32_t(value.size()));
+        write(stream, value, IsFixed());
+    }
+
+    static void read(MessageInputStream & stream, std::vector<T> & value, std::true_type) {
+        const int8_t * data = stream.readRaw(value.size() * Element::size);
+        load(data, stream.isBigEndianness() != MESSAGE_HOST_BIG_ENDIAN, value, IsNumber());
+    }
+
+    static void read(MessageInputStream & stream, std::vector<T> & value, std::false_type) {
+        for (T & element : value) {
+            Element::read(stream, element);
+        }
+    }
+
+    static void write(MessageOutputStream & stream, const std::vector<T> & value, std::true_type) {
+        int8_t * data = stream.writeRaw(value.size() * Element::size);
+        store(data, stream.isBigEndianness() != MESSAGE_HOST_BIG_ENDIAN, value, IsNumber());
+    }
+
+    static void write(MessageOutputStream & stream, const std::vector<T> & value, std::false_type) {
+        for (const T & element : value) {
+            Element::write(stream, element);
+        }
+    }
+
+    static void load(const int8_t * data, bool isSwapped, std::vector<T> & value, std::true_type) {
+        if (isSwapped && Element::size > 1) {
+            copySwapped(value.data(), data, value.size(), Element::size);
+        } else if (!value.empty()) {
+            std::memcpy(value.data(), data, value.size() * Element::size);
+        }
+    }
+
+    static void load(const int8_t * data, bool isSwapped, std::vector<T> & value, std::false_type) {
+        for (size_t i = 0; i < value.size(); i++) {
+            Element::load(data + i * Element::size, isSwapped, value[i]);
+        }
+    }
+
+    static void store(int8_t * data, bool isSwapped, const std::vector<T> & value, std::true_type) {
+        if (isSwapped && Element::size > 1) {
+            copySwapped(data, value.data(), value.size(), Element::size);
+        } else if (!value.empty()) {
+            std::memcpy(data, value.data(), value.size() * Element::size);
+        }
+    }
+
+    static void store(int8_t * data, bool isSwapped, const std::vector<T> & value, std::false_type) {
+        for (size_t i = 0; i < value.size(); i++) {
+            Element::store(data + i * Element::size, isSwapped, value[i]);
+        }
+    }
+};
+
+/**
+ * Codec of an integer written as a varint, or as a zigzag varint when the
+ * integer is signed.
+ */
+template<typename T>
+struct MessageVarintCodec {
+    static_assert(std::is_integral<T>::value, "A varint field must be an integer");
+
+    static const size_t size = 0;
+
+    static void read(MessageInputStream & stream, T & value) {
+        if (sizeof(T) > sizeof(uint32_t)) {
+            uint64_t word = stream.readVarUnsignedLong();
+            value = T(std::is_signed<T>::value ? uint64_t(decodeZigzag(word)) : word);
+        } else {
+            uint32_t word = stream.readVarUnsignedInteger();
+            value = T(std::is_signed<T>::value ? uint32_t(decodeZigzag(word)) : word);
+        }
+    }
+
+    static void write(MessageOutputStream & stream, const T & value) {
+        if (sizeof(T) > sizeof(uint32_t)) {
+            stream.writeVarUnsignedLong(std::is_signed<T>::value
+                                        ? encodeZigzag(int64_t(value)) : uint64_t(value));
+        } else {
+            stream.writeVarUnsignedInteger(std::is_signed<T>::value
+                                           ? encodeZigzag(int32_t(value)) : uint32_t(value));
+        }
+    }
+};
+
+/**
+ * Define a field of a message, declared with {@see MESSAGE_FIELD} or
+ * {@see MESSAGE_VARINT_FIELD}.
+ */
+template<typename C, typename T, T C::*Member, typename Codec = MessageCodec<T>>
+struct MessageField {
+    static const size_t size = Codec::size;
+
+    static void read(MessageInputStream & stream, C & message) {
+        Codec::read(stream, message.*Member);
+    }
+
+    static void write(MessageOutputStream & stream, const C & message) {
+        Codec::write(stream, message.*Member);
+    }
+
+    static void load(const int8_t * data, bool isSwapped, C & message) {
+        Codec::load(data, isSwapped, message.*Member);
+    }
+
+    static void store(int8_t * data, bool isSwapped, const C & message) {
+        Codec::store(data, isSwapped, message.*Member);
+    }
+};
+
+/**
+ * Define the fields of a message in the order they are encoded. Every run
+ * of consecutive fixed width fields is checked once and then loaded or
+ * stored in place, the rest of the fields read and write the stream.
+ *
+ * <pre>
+ * struct PlayerMove {
+ *     uint32_t id;
+ *     float x, y, z;
+ *     std::string name;
+ *
+ *     typedef MessageSchema<
+ *         MESSAGE_VARINT_FIELD(PlayerMove, id),
+ *         MESSAGE_FIELD(PlayerMove, x),
+ *         MESSAGE_FIELD(PlayerMove, y),
+ *         MESSAGE_FIELD(PlayerMove, z),
+ *         MESSAGE_FIELD(PlayerMove, name)> Schema;
+ * };
+ * </pre>
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+template<typename... Fields>
+struct MessageSchema;
+
+template<>
+struct MessageSchema<> {
+    static const size_t run = 0;
+
+    template<typename C>
+    static void decode(MessageInputStream &, C &) {
+    }
+
+    template<typename C>
+    static void encode(MessageOutputStream &, const C &) {
+    }
+
+    template<typename C>
+    static void decodeNext(MessageInputStream &, C &, const int8_t *, bool) {
+    }
+
+    template<typename C>
+    static void encodeNext(MessageOutputStream &, const C &, int8_t *, bool) {
+    }
+};
+
+template<typename Field, typename... Fields>
+struct MessageSchema<Field, Fields...> {
+    typedef MessageSchema<Fields...> Next;
+
+    typedef std::integral_constant<bool, (Field::size > 0)> IsFixed;
+
+    /**
+     * Number of bytes of the run of fixed width fields starting at the
+     * field, 0 if the field isn't fixed width.
+     */
+    static const size_t run = (Field::size > 0 ? Field::size + Next::run : 0);
+
+    /**
+     * Decode a message from a stream.
+     *
+     * @param stream the stream to read from
+     * @param message the message to decode into
+     * @throws std::out_of_range if the stream doesn't have enough bytes
+     */
+    template<typename C>
+    static void decode(MessageInputStream & stream, C & message) {
+        decode(stream, message, IsFixed());
+    }
+
+    /**
+     * Encode a message into a stream.
+     *
+     * @param stream the stream to write into
+     * @param message the message to encode
+     */
+    template<typename C>
+    static void encode(MessageOutputStream & stream, const C & message) {
+        encode(stream, message, IsFixed());
+    }
+
+    template<typename C>
+    static void decode(MessageInputStream & stream, C & message, std::true_type) {
+        const int8_t * data = stream.readRaw(run);
+        decodeRun(stream, message, data, stream.isBigEndianness() != MESSAGE_HOST_BIG_ENDIAN);
+    }
+
+    template<typename C>
+    static void decode(MessageInputStream & stream, C & message, std::false_type) {
+        Field::read(stream, message);
+        Next::decode(stream, message);
+    }
+
+    template<typename C>
+    static void encode(MessageOutputStream & stream, const C & message, std::true_type) {
+        int8_t * data = stream.writeRaw(run);
+        encodeRun(stream, message, data, stream.isBigEndianness() != MESSAGE_HOST_BIG_ENDIAN);
+    }
+
+    template<typename C>
+    static void encode(MessageOutputStream & stream, const C & message, std::false_type) {
+        Field::write(stream, message);
+        Next::encode(stream, message);
+    }
+
+    template<typename C>
+    static void decodeRun(MessageInputStream & stream, C & message, const int8_t * data, bool isSwapped) {
+        Field::load(data, isSwapped, message);
+        Next::decodeNext(stream, message, data + Field::size, isSwapped);
+    }
+
+    template<typename C>
+    static void encodeRun(MessageOutputStream & stream, const C & message, int8_t * data, bool isSwapped) {
+        Field::store(data, isSwapped, message);
+        Next::encodeNext(stream, message, data + Field::size, isSwapped);
+    }
+
+    template<typename C>
+    static void decodeNext(MessageInputStream & stream, C & message, const int8_t * data, bool isSwapped) {
+        decodeNext(stream, message, data, isSwapped, IsFixed());
+    }
+
+    template<typename C>
+    static void encodeNext(MessageOutputStream & stream, const C & message, int8_t * data, bool isSwapped) {
+        encodeNext(stream, message, data, isSwapped, IsFixed());
+    }
+
+    template<typename C>
+    static void decodeNext(MessageInputStream & stream, C & message, const int8_t * data, bool isSwapped,
+                           std::true_type) {
+        decodeRun(stream, message, data, isSwapped);
+    }
+
+    template<typename C>
+    static void decodeNext(MessageInputStream & stream, C & message, const int8_t *, bool, std::false_type) {
+        decode(stream, message, std::false_type());
+    }
+
+    template<typename C>
+    static void encodeNext(MessageOutputStream & stream, const C & message, int8_t * data, bool isSwapped,
+                           std::true_type) {
+        encodeRun(stream, message, data, isSwapped);
+    }
+
+    template<typename C>
+    static void encodeNext(MessageOutputStream & stream, const C & message, int8_t *, bool, std::false_type) {
+        encode(stream, message, std::false_type());
+    }
+};
+
+/**
+ * Decode a message with its schema.
+ *
+ * @param stream the stream to read from
+ * @param message the message to decode into
+ */
+template<typename T>
+inline void decodeMessage(MessageInputStream & stream, T & message) {
+    T::Schema::decode(stream, message);
+}
+
+/**
+ * Encode a message with its schema.
+ *
+ * @param stream the stream to write into
+ * @param message the message to encode
+ */
+template<typename T>
+inline void encodeMessage(MessageOutputStream & stream, const T & message) {
+    T::Schema::encode(stream, message);
+}
+
+} // namespace Ghrum
+
+#endif // _MESSAGE_SCHEMA_HPP_
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _MESSAGE_UNICODE_HPP_
+#define _MESSAGE_UNICODE_HPP_
+
+#include <Types.hpp>
+
+namespace Ghrum {
+
+/**
+ * Maximum number of UTF-8 bytes written for each UTF-16 code unit.
+ */
+#define MESSAGE_UNICODE_RATIO 3
+
+/**
+ * Transcode UTF-16 code units into UTF-8, using the widest vector kernel
+ * the CPU supports for runs of ASCII characters. A surrogate without its
+ * pair is written as U+FFFD.
+ *
+ * @param destination where to write, with room for MESSAGE_UNICODE_RATIO
+ *                    bytes for each code unit
+ * @param source the code units, which don't need to be aligned
+ * @param count the number of code units
+ * @param isSwapped true if the code units aren't in the byte order of the host
+ * @return the number of bytes written
+ */
+size_t encodeUtf8(char * destination, const void * source, size_t count, bool isSwapped);
+
+} // namespace Ghrum
+
+#endif // _MESSAGE_UNICODE_HPP_
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _MESSAGE_VARINT_HPP_
+#define _MESSAGE_VARINT_HPP_
+
+#include "MessageEndian.hpp"
+#include <cstring>
+#include <stdexcept>
+
+namespace Ghrum {
+
+/**
+ * Maximum number of bytes of a varint, enough for 64 bits.
+ */
+#define MESSAGE_VARINT_LENGTH 10
+
+/**
+ * Map a signed value into an unsigned one, so values near zero have
+ * short varints whatever their sign.
+ */
+inline uint32_t encodeZigzag(int32_t value) {
+    return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+inline uint64_t encodeZigzag(int64_t value) {
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+/**
+ * Map back a value mapped by {@see encodeZigzag}.
+ */
+inline int32_t decodeZigzag(uint32_t value) {
+    return int32_t((value >> 1) ^ (~(value & 1) + 1));
+}
+
+inline int64_t decodeZigzag(uint64_t value) {
+    return int64_t((value >> 1) ^ (~(value & 1) + 1));
+}
+
+/**
+ * Write a value as a varint, seven bits per byte, least significant
+ * group first, every byte but the last one has the highest bit set.
+ *
+ * @param data where to write, with room for MESSAGE_VARINT_LENGTH bytes
+ * @param value the value to write
+ * @return the number of bytes written
+ */
+template<typename T>
+inline size_t encodeVarint(int8_t * data, T value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        data[length++] = int8_t(value | 0x80);
+        value >>= 7;
+    }
+    data[length++] = int8_t(value);
+    return length;
+}
+
+/**
+ * Read a varint written by {@see encodeVarint}.
+ *
+ * @param data the bytes to read from
+ * @param length the number of bytes available
+ * @param value where to save the value
+ * @return the number of bytes read, 0 if the varint isn't complete
+ * @throws std::length_error if the varint is longer than the type, or
+ *         its value doesn't fit in the type
+ */
+template<typename T>
+inline size_t decodeVarint(const int8_t * data, size_t length, T & value) {
+    const size_t maximum = (sizeof(T) * 8 + 6) / 7;
+
+    // The last byte of the longest varint only holds the bits left of
+    // the type, such as 4 bits for 32 bit values.
+    const int8_t overflow = int8_t(0x7F & (0x7F << (sizeof(T) * 8 - 7 * (maximum - 1))));
+
+    // Most varints are a single byte.
+    if (length > 0 && data[0] >= 0) {
+        value = T(data[0]);
+        return 1;
+    }
+
+    // With a whole word available the end of the varint is found with
+    // a single load, and the groups are packed without any branch.
+    if (length >= sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        if (MESSAGE_HOST_BIG_ENDIAN) {
+            word = swapBytes(word);
+        }
+        uint64_t stop = ~word & 0x8080808080808080ULL;
+        if (stop != 0) {
+            size_t size = (__builtin_ctzll(stop) >> 3) + 1;
+            if (size > maximum || (size == maximum && (data[size - 1] & overflow) != 0)) {
+                throw std::length_error("Malformed varint");
+            }
+            word &= (stop ^ (stop - 1)) & 0x7F7F7F7F7F7F7F7FULL;
+            word = (word & 0x7FULL)
+                   | ((word >> 1) & (0x7FULL << 7))
+                   | ((word >> 2) & (0x7FULL << 14))
+                   | ((word >> 3) & (0x7FULL << 21))
+                   | ((word >> 4) & (0x7FULL << 28))
+                   | ((word >> 5) & (0x7FULL << 35))
+                   | ((word >> 6) & (0x7FULL << 42))
+                   | ((word >> 7) & (0x7FULL << 49));
+            value = T(word);
+            return size;
+        }
+    }
+
+    // The last bytes of the input and varints longer than a word are
+    // read one byte at a time.
+    uint64_t result = 0;
+    for (size_t i = 0; i < maximum; i++) {
+        if (i == length) {
+            return 0;
+        }
+        result |= uint64_t(data[i] & 0x7F) << (7 * i);
+        if (data[i] >= 0) {
+            if (i == maximum - 1 && (data[i] & overflow) != 0) {
+                throw std::length_error("Malformed varint");
+            }
+            value = T(result);
+            return i + 1;
+        }
+    }
+    throw std::length_error("Malformed varint");
+}
+
+} // namespace Ghrum
+
+#endif // _MESSAGE_VARINT_HPP_
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _REACTOR_HPP_
+#define _REACTOR_HPP_
+
+#include <Types.hpp>
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+namespace Ghrum {
+
+/**
+ * Encapsulate a thread that runs its own io_service, every socket of
+ * a reactor is handled only by the thread of the reactor.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class Reactor {
+public:
+    /**
+     * Default constructor of the reactor.
+     *
+     * @param id the index of the reactor
+     */
+    Reactor(size_t id);
+
+    /**
+     * Destructor of the reactor, stops the reactor.
+     */
+    ~Reactor();
+
+    /**
+     * Start the thread of the reactor.
+     */
+    void start();
+
+    /**
+     * Stop the thread of the reactor, every pending handler is
+     * discarded.
+     */
+    void stop();
+
+    /**
+     * Return the index of the reactor.
+     */
+    size_t getId();
+
+    /**
+     * Return if the caller runs in the thread of the reactor.
+     */
+    bool isCurrentThread();
+
+    /**
+     * Return the service of the reactor.
+     */
+    boost::asio::io_service & getService();
+private:
+    /**
+     * Run the service of the reactor until it is stopped.
+     */
+    void run();
+private:
+    size_t id_;
+    boost::asio::io_service service_;
+    std::unique_ptr<boost::asio::io_service::work> work_;
+    std::unique_ptr<boost::thread> thread_;
+};
+
+}; // namespace Ghrum
+
+#endif // _REACTOR_HPP_
@@ -16,10 +16,327 @@
 #ifndef _SESSION_HPP_
 #define _SESSION_HPP_
 
+#include "MessageBuffer.hpp"
+#include "MessageCompressor.hpp"
+#include "MessageFrameParser.hpp"
+#include "MessageOutputStream.hpp"
+#include "Reactor.hpp"
 #include <Network/ISession.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <atomic>
+#include <chrono>
+#include <vector>
 
 namespace Ghrum {
 
-} // namespace Ghrum
+/**
+ * Number of bytes a session asks the socket for on every read.
+ */
+#define SESSION_READ_LENGTH 16384
+
+/**
+ * Default number of bytes waiting to be written under which a congested
+ * session is writable again.
+ */
+#define SESSION_LOW_WATERMARK 262144
+
+/**
+ * Default number of bytes waiting to be written over which a session is
+ * congested.
+ */
+#define SESSION_HIGH_WATERMARK 1048576
+
+/**
+ * Default maximum number of bytes waiting to be written, a session that
+ * goes over it is disconnected.
+ */
+#define SESSION_SEND_LIMIT 8388608
+
+/**
+ * Default number of milliseconds a session can stay congested before
+ * it is disconnected.
+ */
+#define SESSION_SLOW_TIMEOUT 10000
+
+/**
+ * Encapsulate the bounds of the bytes a session can have waiting to be
+ * written, either pending or being written.
+ */
+struct SessionSendLimit {
+    /**
+     * Default constructor of the limits.
+     *
+     * @param lowWatermark the bytes under which a congested session is writable again
+     * @param highWatermark the bytes over which a session is congested
+     * @param limit the bytes over which a session is disconnected
+     * @param timeout the milliseconds a session can stay congested
+     */
+    SessionSendLimit(size_t lowWatermark = SESSION_LOW_WATERMARK, size_t highWatermark = SESSION_HIGH_WATERMARK,
+                     size_t limit = SESSION_SEND_LIMIT, size_t timeout = SESSION_SLOW_TIMEOUT)
+        : lowWatermark(lowWatermark), highWatermark(highWatermark), limit(limit), timeout(timeout) {
+    }
+
+    size_t lowWatermark, highWatermark, limit, timeout;
+};
+
+class SessionManager;
+
+/**
+ * Implementation of {@see ISession}, over a TCP socket. A session lives
+ * in a single reactor, so its buffers are only touched by the thread of
+ * that reactor.
+ *
+ * A session that falls behind is congested once its bytes waiting to be
+ * written go over the high watermark, until they go back under the low
+ * watermark. While congested, droppable messages are discarded and the
+ * session is disconnected if it stays congested for too long.
+ *
+ * Once compression is set, every frame carries after its prefix the
+ * varint length of its body once decompressed, or 0 when the body is
+ * sent as is.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class Session : public ISession, public std::enable_shared_from_this<Session> {
+private:
+    /**
+     * Define a run of bytes to be written, either from the own buffer
+     * of the session or from a shared buffer.
+     */
+    struct Segment {
+        std::shared_ptr<const MessageBuffer> buffer;
+        size_t offset, length;
+    };
+public:
+    /**
+     * Default constructor of the session.
+     *
+     * @param manager the manager of the session
+     * @param reactor the reactor of the session
+     * @param id the id of the session
+     */
+    Session(SessionManager & manager, Reactor & reactor, size_t id);
+
+    /**
+     * Return the id of the session.
+     */
+    size_t getId();
+
+    /**
+     * Return the remote address of the session.
+     */
+    std::string getAddress();
+
+    /**
+     * Return if the session is connected.
+     */
+    bool isConnected();
+
+    /**
+     * Return if the session is congested, producers should hold back
+     * their messages until it isn't.
+     */
+    bool isCongested();
+
+    /**
+     * Return the number of bytes waiting to be written, either pending
+     * or being written.
+     */
+    size_t getQueueDepth();
+
+    /**
+     * Send bytes to the session, can be called from any thread.
+     *
+     * @param data the bytes to send
+     * @param length the number of bytes
+     * @param isDroppable if the bytes are discarded while the session is congested
+     */
+    void send(const int8_t * data, size_t length, bool isDroppable = false);
+
+    /**
+     * Send every byte written into a stream, can be called from any thread.
+     *
+     * @param stream the stream to send
+     * @param isDroppable if the bytes are discarded while the session is congested
+     */
+    void send(MessageOutputStream & stream, bool isDroppable = false);
+
+    /**
+     * Send an immutable buffer, can be called from any thread. The buffer
+     * is written as it is without any copy, and released once the write
+     * completes, so the same buffer can be sent to many sessions.
+     *
+     * @param buffer the buffer to send
+     * @param isDroppable if the buffer is discarded while the session is congested
+     */
+    void send(std::shared_ptr<const MessageBuffer> buffer, bool isDroppable = false);
+
+    /**
+     * Close the session, can be called from any thread.
+     */
+    void close();
+
+    /**
+     * Compress the body of every frame from the given size, in both
+     * directions, can be called from any thread. It applies from the
+     * next message sent and received, so both peers must switch at the
+     * same message. Sessions without frames can't be compressed.
+     *
+     * @param compression the algorithm, or None to stop compressing
+     * @param threshold the number of bytes from which a body is compressed
+     * @throws std::invalid_argument if the session can't use the algorithm
+     */
+    void setCompression(MessageCompression compression, size_t threshold = MESSAGE_COMPRESSION_THRESHOLD);
+
+    /**
+     * Return the reactor of the session.
+     */
+    Reactor & getReactor();
+
+    /**
+     * Return the socket of the session.
+     */
+    boost::asio::ip::tcp::socket & getSocket();
+
+    /**
+     * Start reading from the session, called from the thread of the
+     * reactor once the session has been accepted.
+     */
+    void start();
+
+    /**
+     * Start the session without a socket, to be fed the bytes of a
+     * capture instead. Every byte written is discarded as soon as it is
+     * flushed. Called from the thread of the reactor.
+     */
+    void startReplay();
+
+    /**
+     * Hand bytes to the session as if they were read from its socket,
+     * called from the thread of the reactor.
+     *
+     * @param data the bytes received
+     * @param length the number of bytes received
+     */
+    void receive(const int8_t * data, size_t length);
+
+    /**
+     * Write every message sent since the last flush with a single
+     * write, called from the thread of the reactor.
+     */
+    void flush();
+private:
+    /**
+     * Append bytes to the pending bytes of the session, they are written
+     * on the next flush.
+     */
+    void write(const int8_t * data, size_t length, bool isDroppable);
+
+    /**
+     * Append bytes, already encoded, to the pending bytes of the session.
+     */
+    void doAppend(const int8_t * data, size_t length, bool isDroppable);
+
+    /**
+     * Append a shared buffer to the pending bytes of the session, it is
+     * written on the next flush.
+     */
+    void write(std::shared_ptr<const MessageBuffer> buffer, bool isDroppable);
+
+    /**
+     * Account for bytes about to be appended to the pending bytes.
+     *
+     * @return false if the bytes must not be appended
+     */
+    bool doReserve(size_t length, bool isDroppable);
+
+    /**
+     * Disconnect the session if it has been congested for too long.
+     *
+     * @return true if the session was disconnected
+     */
+    bool doCheckSlow();
+
+    /**
+     * Check the timeout of a congested session once it is due, even if
+     * nothing is written to the session meanwhile.
+     */
+    void doWaitSlow();
+
+    /**
+     * Queue the session to be flushed at the end of the tick.
+     */
+    void doQueue();
+
+    /**
+     * Start reading from the socket.
+     */
+    void doRead();
+
+    /**
+     * Handle the completion of a read.
+     */
+    void onRead(const boost::system::error_code & error, size_t length);
+
+    /**
+     * Hand every frame received to the manager, closing the session if
+     * any of them is malformed.
+     */
+    void doProcess();
+
+    /**
+     * Hand every complete frame received to the manager, the bytes of
+     * a partial frame stay in the buffer for the next read.
+     */
+    void doReceive();
+
+    /**
+     * Hand the body of a frame to the manager, decompressing it first if
+     * the session is compressed.
+     */
+    void doDispatch(const int8_t * data, size_t size);
+
+    /**
+     * Frame again every frame of the given bytes for a compressed session.
+     *
+     * @throws std::length_error if the bytes end with a partial frame, or
+     *         a frame goes over the limit once framed again
+     */
+    void doEncode(const int8_t * data, size_t length, MessageBuffer & output);
+
+    /**
+     * Start writing the pending bytes to the socket.
+     */
+    void doWrite();
+
+    /**
+     * Handle the completion of a write.
+     */
+    void onWrite(const boost::system::error_code & error, size_t length);
+
+    /**
+     * Close the socket and notify the manager, only once.
+     */
+    void doClose();
+private:
+    SessionManager & manager_;
+    Reactor & reactor_;
+    size_t id_;
+    boost::asio::ip::tcp::socket socket_;
+    boost::asio::steady_timer slow_;
+    std::atomic<bool> connected_, congested_;
+    std::atomic<size_t> depth_;
+    bool writing_, queued_, flushing_, isReplay_;
+    size_t messages_, sendingLength_, threshold_;
+    SessionSendLimit limit_;
+    MessageCompression compression_;
+    std::chrono::steady_clock::time_point congestedAt_;
+    MessageFrameParser parser_;
+    MessageBuffer input_, pending_, sending_;
+    std::vector<Segment> pendingSegment_, sendingSegment_;
+    std::vector<boost::asio::const_buffer> sequence_;
+};
+
+}; // namespace Ghrum
 
 #endif // _SESSION_HPP_
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _SESSION_CAPTURE_HPP_
+#define _SESSION_CAPTURE_HPP_
+
+#include "MessageBuffer.hpp"
+#include "MessageFrameParser.hpp"
+#include <boost/thread.hpp>
+#include <chrono>
+#include <cstdio>
+
+namespace Ghrum {
+
+/**
+ * Magic number at the start of every capture, "GHCP".
+ */
+#define SESSION_CAPTURE_MAGIC 0x50434847
+
+/**
+ * Version of the format of the captures.
+ */
+#define SESSION_CAPTURE_VERSION 1
+
+/**
+ * Number of bytes of records kept in memory before they are handed to
+ * the writer of the file.
+ */
+#define SESSION_CAPTURE_BUFFER 1048576
+
+/**
+ * Enumeration of the records of a capture.
+ */
+enum class SessionRecord : uint8_t {
+    Connect,
+    Receive,
+    Close
+};
+
+/**
+ * Encapsulate a file where the traffic received by every session is
+ * recorded, to be replayed later by {@see SessionReplay}.
+ *
+ * The file starts with a header of the magic number, the version and
+ * how the frames are prefixed. Every record that follows is its type,
+ * the nanoseconds since the previous record and the session id, as
+ * varints, then for received bytes their varint length and the bytes
+ * exactly as read from the socket.
+ *
+ * The records are kept in memory and written by a thread of their own,
+ * a reactor never waits for the file.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class SessionCapture {
+public:
+    /**
+     * Default constructor of the capture, creates the file and starts
+     * its writer.
+     *
+     * @param path the path of the file
+     * @param parser how the bytes received are split into frames
+     * @throws std::runtime_error if the file can't be created
+     */
+    SessionCapture(const std::string & path, const MessageFrameParser & parser);
+
+    /**
+     * Destructor of the capture, stops the writer, writes every record
+     * left and closes the file.
+     */
+    ~SessionCapture();
+
+    /**
+     * Record an event of a session, can be called from any thread.
+     *
+     * @param record the type of the record
+     * @param session the id of the session
+     * @param data the bytes received, for a receive record
+     * @param length the number of bytes received
+     */
+    void write(SessionRecord record, size_t session, const int8_t * data = nullptr, size_t length = 0);
+
+    /**
+     * Hand every record kept in memory to the writer of the file.
+     */
+    void flush();
+private:
+    /**
+     * Write the records handed by the reactors until the capture is
+     * destroyed, run by the thread of the writer.
+     */
+    void run();
+
+    /**
+     * Write the given records to the file.
+     */
+    void doWrite(MessageBuffer & buffer);
+
+    SessionCapture(const SessionCapture &);
+    SessionCapture & operator=(const SessionCapture &);
+private:
+    boost::mutex mutex_;
+    boost::condition_variable condition_;
+    FILE * file_;
+    MessageBuffer buffer_, pending_;
+    bool isReady_, isRunning_;
+    std::chrono::steady_clock::time_point last_;
+    std::unique_ptr<boost::thread> thread_;
+};
+
+}; // namespace Ghrum
+
+#endif // _SESSION_CAPTURE_HPP_
@@ -16,10 +16,363 @@
 #ifndef _SESSION_MANAGER_HPP_
 #define _SESSION_MANAGER_HPP_
 
+#include "Session.hpp"
+#include "SessionCapture.hpp"
+#include "MessageInputStream.hpp"
 #include <Network/ISessionManager.hpp>
+#include <Utilities/Delegate.hpp>
+#include <unordered_map>
 
 namespace Ghrum {
 
-} // namespace Ghrum
+/**
+ * Number of milliseconds an acceptor waits before accepting again after
+ * an accept failed, such as when the process runs out of descriptors.
+ */
+#define SESSION_ACCEPT_BACKOFF 100
+
+/**
+ * Implementation of {@see ISessionManager}, with one reactor per core.
+ * Every reactor accepts its own sessions when the platform can share
+ * the port between sockets, otherwise the first reactor accepts every
+ * session and hands them out in turns.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class SessionManager : public ISessionManager {
+public:
+    /**
+     * A type definition of a delegate called when a session connects
+     * or disconnects.
+     */
+    typedef Delegate<void(Session &)> SessionDelegate;
+
+    /**
+     * A type definition of a delegate called when a frame is received,
+     * or when bytes are received if sessions have no frames, then it
+     * must consume every complete message of the stream.
+     */
+    typedef Delegate<void(Session &, MessageInputStream &)> MessageDelegate;
+
+    /**
+     * A type definition of a delegate called when a session becomes
+     * congested, or writable again.
+     */
+    typedef Delegate<void(Session &, bool)> CongestionDelegate;
+public:
+    /**
+     * Default constructor of the manager.
+     */
+    SessionManager();
+
+    /**
+     * Destructor of the manager, stops the manager.
+     */
+    ~SessionManager();
+
+    /**
+     * Start accepting sessions.
+     *
+     * @param address the address to listen at
+     * @param port the port to listen at
+     * @param reactors the number of reactors, 0 for one per core
+     */
+    void start(const std::string & address, uint16_t port, size_t reactors);
+
+    /**
+     * Stop every reactor, every session is closed first and the
+     * disconnect delegate called for it.
+     */
+    void stop();
+
+    /**
+     * Write every message sent to every session since the last flush,
+     * one write per session. Called by the scheduler at the end of
+     * every tick.
+     */
+    void flush();
+
+    /**
+     * Send a message to every session connected, can be called from any
+     * thread. The message is encoded once and every session writes the
+     * same buffer.
+     *
+     * @param stream the stream to send
+     * @param isDroppable if congested sessions discard the message
+     */
+    void broadcast(MessageOutputStream & stream, bool isDroppable = false);
+
+    /**
+     * Send a message to many sessions, can be called from any thread.
+     * The message is encoded once and every session writes the same
+     * buffer.
+     *
+     * @param sessions the sessions to send to
+     * @param stream the stream to send
+     * @param isDroppable if congested sessions discard the message
+     */
+    void broadcast(const std::vector<std::shared_ptr<Session>> & sessions, MessageOutputStream & stream,
+                   bool isDroppable = false);
+
+    /**
+     * Stop accepting sessions, the sessions connected are kept. Can be
+     * called from any thread once the manager has started.
+     */
+    void stopAccepting();
+
+    /**
+     * Start recording the bytes received by every session into a capture,
+     * can be called from any thread. A capture in progress is finished.
+     *
+     * @param path the path of the capture
+     * @throws std::runtime_error if the capture can't be created
+     */
+    void startCapture(const std::string & path);
+
+    /**
+     * Stop recording the bytes received, the capture is finished once
+     * no session is writing to it.
+     */
+    void stopCapture();
+
+    /**
+     * Create a session fed from a capture instead of a socket, can be
+     * called from any thread once the manager has started. The connect
+     * delegate is called in its reactor, as for any other session.
+     *
+     * @return the session
+     * @throws std::runtime_error if the manager hasn't started
+     */
+    std::shared_ptr<Session> createReplaySession();
+
+    /**
+     * Sets the delegate called in the reactor of a session when it
+     * connects, must be called before the manager starts.
+     *
+     * @param callback the delegate
+     */
+    void setConnectDelegate(SessionDelegate callback);
+
+    /**
+     * Sets the delegate called in the reactor of a session when it
+     * disconnects, must be called before the manager starts.
+     *
+     * @param callback the delegate
+     */
+    void setDisconnectDelegate(SessionDelegate callback);
+
+    /**
+     * Sets the delegate called in the reactor of a session when it
+     * receives bytes, must be called before the manager starts.
+     *
+     * @param callback the delegate
+     */
+    void setMessageDelegate(MessageDelegate callback);
+
+    /**
+     * Sets the delegate called in the reactor of a session when it becomes
+     * congested, or writable again, must be called before the manager
+     * starts.
+     *
+     * @param callback the delegate
+     */
+    void setCongestionDelegate(CongestionDelegate callback);
+
+    /**
+     * Sets the bounds of the bytes every session can have waiting to be
+     * written, must be called before the manager starts.
+     *
+     * @param limit the bounds
+     */
+    void setSendLimit(const SessionSendLimit & limit);
+
+    /**
+     * Return the bounds of the bytes every session can have waiting to
+     * be written.
+     */
+    const SessionSendLimit & getSendLimit();
+
+    /**
+     * Sets how the bytes received by every session are split into
+     * messages, must be called before the manager starts.
+     *
+     * @param parser the frame parser
+     */
+    void setFrameParser(const MessageFrameParser & parser);
+
+    /**
+     * Return how the bytes received by every session are split into
+     * messages.
+     */
+    const MessageFrameParser & getFrameParser();
+
+    /**
+     * Return a session by its id, or nullptr.
+     *
+     * @param id the id of the session
+     */
+    std::shared_ptr<Session> getSession(size_t id);
+
+    /**
+     * Return the number of sessions connected.
+     */
+    size_t getSessionCount();
+
+    /**
+     * Return the number of reactors.
+     */
+    size_t getReactorCount();
+
+    /**
+     * Return the local port the manager listens at.
+     */
+    uint16_t getPort();
+
+    /**
+     * Return the number of socket writes done by every session.
+     */
+    uint64_t getWriteCount();
+
+    /**
+     * Return the number of messages sent by every session.
+     */
+    uint64_t getMessageCount();
+
+    /**
+     * Return the number of droppable messages discarded by congested
+     * sessions.
+     */
+    uint64_t getDropCount();
+
+    /**
+     * Return the number of sessions disconnected for being too slow.
+     */
+    uint64_t getSlowCount();
+
+    /**
+     * Return the number of bytes waiting to be written by every session.
+     */
+    size_t getQueueDepth();
+
+    /**
+     * Called by a session, in its reactor, when it reads bytes from its
+     * socket.
+     *
+     * @param session the session
+     * @param data the bytes read
+     * @param length the number of bytes read
+     */
+    void onRead(Session & session, const int8_t * data, size_t length);
+
+    /**
+     * Called by a session when it receives bytes.
+     *
+     * @param session the session
+     * @param stream the bytes received
+     */
+    void onReceive(Session & session, MessageInputStream & stream);
+
+    /**
+     * Called by a session, in its reactor, when it has messages to
+     * be written on the next flush.
+     *
+     * @param session the session
+     */
+    void onQueue(Session & session);
+
+    /**
+     * Called by a session when it writes its pending messages.
+     *
+     * @param session the session
+     * @param messages the number of messages written
+     */
+    void onWrite(Session & session, size_t messages);
+
+    /**
+     * Called by a session, in its reactor, when it becomes congested or
+     * writable again.
+     *
+     * @param session the session
+     * @param isCongested if the session is congested
+     */
+    void onCongestion(Session & session, bool isCongested);
+
+    /**
+     * Called by a session when it discards a droppable message.
+     */
+    void onDrop();
+
+    /**
+     * Called by a session when it is disconnected for being too slow.
+     */
+    void onSlow();
+
+    /**
+     * Called by a session when it is closed.
+     *
+     * @param session the session
+     */
+    void onClose(Session & session);
+private:
+    /**
+     * Start accepting a session in an acceptor.
+     *
+     * @param index the index of the acceptor
+     */
+    void doAccept(size_t index);
+
+    /**
+     * Handle the completion of an accept.
+     */
+    void onAccept(size_t index, std::shared_ptr<Session> session, const boost::system::error_code & error);
+
+    /**
+     * Wait until every reactor has run the handlers posted before.
+     */
+    void doWait();
+
+    /**
+     * Record an event of a session into the capture in progress, if any.
+     */
+    void doCapture(SessionRecord record, Session & session, const int8_t * data = nullptr,
+                   size_t length = 0);
+
+    /**
+     * Flush every session queued in a reactor, called from the thread
+     * of the reactor.
+     *
+     * @param index the index of the reactor
+     */
+    void doFlush(size_t index);
+
+    /**
+     * Send a shared buffer to many sessions, one handler per reactor.
+     *
+     * @param sessions the sessions to send to
+     * @param buffer the buffer to send
+     * @param isDroppable if congested sessions discard the buffer
+     */
+    void doBroadcast(const std::vector<std::shared_ptr<Session>> & sessions,
+                     std::shared_ptr<const MessageBuffer> buffer, bool isDroppable);
+protected:
+    boost::mutex mutex_;
+    bool isShared_;
+    std::atomic<size_t> nextId_, nextReactor_;
+    std::atomic<bool> isCapturing_;
+    std::atomic<uint64_t> writes_, messages_, drops_, slows_;
+    SessionDelegate connect_, disconnect_;
+    MessageDelegate message_;
+    CongestionDelegate congestion_;
+    MessageFrameParser parser_;
+    SessionSendLimit limit_;
+    std::shared_ptr<SessionCapture> capture_;
+    std::vector<std::unique_ptr<Reactor>> reactor_;
+    std::vector<std::unique_ptr<boost::asio::ip::tcp::acceptor>> acceptor_;
+    std::vector<std::unique_ptr<boost::asio::deadline_timer>> backoff_;
+    std::vector<std::vector<std::shared_ptr<Session>>> queued_;
+    std::unordered_map<size_t, std::shared_ptr<Session>> session_;
+};
+
+}; // namespace Ghrum
 
 #endif // _SESSION_MANAGER_HPP_
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _SESSION_REPLAY_HPP_
+#define _SESSION_REPLAY_HPP_
+
+#include "SessionManager.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace Ghrum {
+
+/**
+ * Maximum number of records handed to the reactors and not processed
+ * yet, when a capture is replayed as fast as possible.
+ */
+#define SESSION_REPLAY_WINDOW 4096
+
+/**
+ * Encapsulate a capture written by {@see SessionCapture}, mapped into
+ * memory and fed back into sessions of a manager. The bytes of every
+ * record go through the frame parser and the delegates of the manager
+ * as if they were read from a socket, while everything written back is
+ * discarded.
+ *
+ * @author Agustin Alvarez <wolftein@ghrum.org>
+ */
+class SessionReplay {
+public:
+    /**
+     * Default constructor of the replay, maps the capture.
+     *
+     * @param manager the manager of the sessions
+     * @param path the path of the capture
+     * @throws std::runtime_error if the capture can't be read, or its
+     *         frames aren't the ones of the manager
+     */
+    SessionReplay(SessionManager & manager, const std::string & path);
+
+    /**
+     * Replay every record of the capture, returns once every session
+     * replayed has processed them. The manager stops accepting sessions
+     * first, and the replay stops at the first record that is malformed,
+     * or cut short.
+     *
+     * @param isRealtime if the records are replayed at the pace they
+     *        were captured, or as fast as possible
+     * @throws std::runtime_error if the manager hasn't started
+     */
+    void run(bool isRealtime);
+
+    /**
+     * Return the number of records replayed.
+     */
+    uint64_t getRecordCount();
+
+    /**
+     * Return the number of bytes replayed.
+     */
+    uint64_t getByteCount();
+
+    /**
+     * Return the number of sessions replayed.
+     */
+    uint64_t getSessionCount();
+
+    /**
+     * Return the number of milliseconds the last replay took.
+     */
+    uint64_t getElapsed();
+private:
+    /**
+     * Wait until the reactors have no more than the given number of
+     * records left to process.
+     */
+    void doWait(size_t window);
+
+    SessionReplay(const SessionReplay &);
+    SessionReplay & operator=(const SessionReplay &);
+private:
+    SessionManager & manager_;
+    boost::interprocess::file_mapping file_;
+    boost::interprocess::mapped_region region_;
+    size_t offset_;
+    std::atomic<size_t> pending_;
+    uint64_t records_, bytes_, sessions_, elapsed_;
+};
+
+}; // namespace Ghrum
+
+#endif // _SESSION_REPLAY_HPP_
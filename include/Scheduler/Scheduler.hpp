@@ -20,6 +20,7 @@
 #include <Scheduler/IScheduler.hpp>
 #include <boost/heap/fibonacci_heap.hpp>
 #include <boost/function.hpp>
+#include <atomic>
 
 namespace Ghrum {
 
@@ -49,6 +50,12 @@ public:
      */
     void runMainThread();
 
+    /**
+     * Stop the main thread execution of the scheduler at the end
+     * of the current tick, can be called from any thread.
+     */
+    void setCancelled();
+
     /**
      * {@inheritDoc}
      */
@@ -103,6 +110,14 @@ public:
      * {@inheritDoc}
      */
     ITask & asyncAnonymousTask(Delegate<void()> callback, TaskPriority priority);
+
+    /**
+     * Add a delegate to be executed in the main thread at the end
+     * of every tick, must be called before the scheduler starts.
+     *
+     * @param callback the delegate
+     */
+    void addTickDelegate(Delegate<void()> callback);
 private:
     /**
      * Run every parallel task available.
@@ -119,9 +134,11 @@ private:
     void runTaskQueue(std::queue<std::shared_ptr<Task>> & queue);
 protected:
     boost::mutex mutex_;
-    bool active_, overloaded_;
+    std::atomic<bool> active_;
+    bool overloaded_;
     size_t uptime_, thread_, iterationPerSecond_, nextTick_;
     TaskWorkerGroup workerGroup_;
+    std::vector<Delegate<void()>> tickDelegate_;
     boost::heap::fibonacci_heap<std::shared_ptr<Task>, boost::heap::compare<Comparator>> taskQueue_;
 };
 
@@ -15,52 +15,142 @@
  */
 
 #include <Event/EventHandler.hpp>
-#include <algorithm>
+#include <GhrumAPI.hpp>
+#include <chrono>
 
 using namespace Ghrum;
 
+/////////////////////////////////////////////////////////////////
+// {@see EventHandler::EventHandler} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+EventHandler::EventHandler(size_t id, EventMetrics & metrics)
+    : id_(id), metrics_(metrics) {
+}
+
 /////////////////////////////////////////////////////////////////
 // {@see EventHandler::isEmpty} /////////////////////////////////
 /////////////////////////////////////////////////////////////////
 bool EventHandler::isEmpty() {
     for (int i = 0; i <= EventPriority::Monitor; i++) {
-        if (delegates_[i].size() > 0)
-            return true;
+        if (delegates_[i].size() > 0 || keyed_[i].size() > 0)
+            return false;
     }
-    return false;
+    return true;
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see EventHandler::callEvent} ///////////////////////////////
 /////////////////////////////////////////////////////////////////
 void EventHandler::callEvent(Event & event) {
+    bool isSampled = metrics_.isSampled();
     for (int i = 0; i <= EventPriority::Monitor; i++)
-        for (auto & delegate : delegates_[i])
-            delegate(event);
+        callDelegates(event, i, nullptr, isSampled);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventHandler::callEvent} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventHandler::callEvent(Event & event, size_t key) {
+    bool isSampled = metrics_.isSampled();
+    for (int i = 0; i <= EventPriority::Monitor; i++)
+        callDelegates(event, i, &key, isSampled);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventHandler::callEventAsync} //////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventHandler::callEventAsync(std::shared_ptr<Event> event, const size_t * key,
+                                  const IEventManager::EventDelegate * completion) {
+    bool isSampled = metrics_.isSampled();
+    for (int i = 0; i < EventPriority::Monitor; i++)
+        callDelegates(*event, i, key, isSampled);
+
+    // Without Monitor delegates the completion doesn't wait for anything.
+    std::vector<Slot> * keyed
+        = (key != nullptr ? getDelegates(EventPriority::Monitor, *key) : nullptr);
+    if (delegates_[EventPriority::Monitor].empty() && keyed == nullptr) {
+        if (completion != nullptr)
+            (*completion)(*event);
+        return;
+    }
+
+    // Every Monitor delegate of the event runs in a single task, followed
+    // by the completion. The task keeps the handler and the event alive
+    // until it returns.
+    std::shared_ptr<EventHandler> self = shared_from_this();
+    size_t route = (key != nullptr ? *key : 0);
+    bool isRouted = (key != nullptr), isCompletion = (completion != nullptr);
+    IEventManager::EventDelegate function = (isCompletion ? *completion : IEventManager::EventDelegate());
+    Delegate<void ()> task([self, event, route, isRouted, isCompletion, function, isSampled]() {
+        try {
+            self->callDelegates(*event, EventPriority::Monitor, isRouted ? &route : nullptr, isSampled);
+            if (isCompletion)
+                function(*event);
+        } catch (std::exception & ex) {
+            BOOST_LOG_TRIVIAL(warning)
+                    << "[!!] <EventManager> Listener has trigger an exception: " << ex.what();
+        }
+    });
+    GhrumAPI::getScheduler().asyncAnonymousTask(task);
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see EventHandler::addDelegate} /////////////////////////////
 /////////////////////////////////////////////////////////////////
-bool EventHandler::addDelegate(IEventManager::EventDelegate function, EventPriority priority) {
-    std::vector<IEventManager::EventDelegate>::iterator it
-        = std::find(delegates_[priority].begin(), delegates_[priority].end(), function);
-    if (it != delegates_[priority].end()) {
-        return false;
+void EventHandler::addDelegate(IEventManager::EventDelegate function, EventPriority priority, size_t owner) {
+    Slot slot = { function, &metrics_.getCounter(id_, priority, owner) };
+    delegates_[priority].push_back(slot);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventHandler::addDelegate} /////////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventHandler::addDelegate(IEventManager::EventDelegate function, EventPriority priority, size_t owner, size_t key) {
+    Slot slot = { function, &metrics_.getCounter(id_, priority, owner) };
+    keyed_[priority][key].push_back(slot);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventHandler::getDelegates} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+std::vector<EventHandler::Slot> * EventHandler::getDelegates(int priority, size_t key) {
+    if (keyed_[priority].empty()) {
+        return nullptr;
     }
-    delegates_[priority].push_back(function);
-    return true;
+    std::unordered_map<size_t, std::vector<Slot>>::iterator it
+        = keyed_[priority].find(key);
+    return (it != keyed_[priority].end() ? &it->second : nullptr);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventHandler::callDelegates} ///////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventHandler::callDelegates(Event & event, int priority, const size_t * key, bool isSampled) {
+    for (auto & slot : delegates_[priority])
+        callDelegate(event, slot, isSampled);
+
+    // Keyed delegates are only reached through their key, the rest of
+    // them are never called.
+    std::vector<Slot> * keyed
+        = (key != nullptr ? getDelegates(priority, *key) : nullptr);
+    if (keyed != nullptr)
+        for (auto & slot : *keyed)
+            callDelegate(event, slot, isSampled);
 }
 
 /////////////////////////////////////////////////////////////////
-// {@see EventHandler::removeDelegate} //////////////////////////
+// {@see EventHandler::callDelegate} ////////////////////////////
 /////////////////////////////////////////////////////////////////
-bool EventHandler::removeDelegate(IEventManager::EventDelegate function, EventPriority priority) {
-    std::vector<IEventManager::EventDelegate>::iterator it
-        = std::find(delegates_[priority].begin(), delegates_[priority].end(), function);
-    if (it == delegates_[priority].end()) {
-        return false;
+void EventHandler::callDelegate(Event & event, const Slot & slot, bool isSampled) {
+    if (!isSampled) {
+        slot.function(event);
+        return;
     }
-    delegates_[priority].erase(it);
-    return true;
+    std::chrono::steady_clock::time_point startClock
+        = std::chrono::steady_clock::now();
+    slot.function(event);
+    std::chrono::steady_clock::time_point endClock
+        = std::chrono::steady_clock::now();
+    EventMetrics::record(*slot.counter,
+                         std::chrono::duration_cast<std::chrono::nanoseconds>(endClock - startClock).count());
 }
\ No newline at end of file
@@ -16,40 +16,221 @@
 
 #include <Event/EventManager.hpp>
 #include <GhrumAPI.hpp>
+#include <algorithm>
+#include <set>
+#include <unordered_set>
 
 using namespace Ghrum;
 
+/**
+ * Version of the last dispatch snapshot published by any manager.
+ */
+static std::atomic<size_t> g_DispatchVersion(0);
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::EventManager} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+EventManager::EventManager()
+    : version_(0), isDispatchChanged_(true), postedLength_(0) {
+    publishDispatch();
+}
+
 /////////////////////////////////////////////////////////////////
 // {@see EventManager::emitEvent} ///////////////////////////////
 /////////////////////////////////////////////////////////////////
 void EventManager::emitEvent(Event & event, size_t id) {
-    std::unordered_map<size_t, std::unique_ptr<EventHandler>>::iterator it
-            = handler_.find(id);
-    if (it != handler_.end())
-        it->second->callEvent(event);
+    std::shared_ptr<EventHandler> dispatch = getDispatch(id);
+    if (dispatch)
+        dispatch->callEvent(event);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::emitEventShared} /////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventManager::emitEventShared(std::shared_ptr<Event> event, size_t id, const size_t * key, bool isOrdered,
+                                   const EventDelegate * completion) {
+    std::shared_ptr<EventHandler> dispatch = getDispatch(id);
+    if (!dispatch) {
+        if (completion != nullptr)
+            (*completion)(*event);
+        return;
+    }
+
+    // Ordered events call Monitor delegates in the lane as well, so
+    // the next event of the lane never overtakes them.
+    if (!isOrdered) {
+        dispatch->callEventAsync(event, key, completion);
+        return;
+    }
+    if (key != nullptr)
+        dispatch->callEvent(*event, *key);
+    else
+        dispatch->callEvent(*event);
+    if (completion != nullptr)
+        (*completion)(*event);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::emitEventKeyed} //////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventManager::emitEventKeyed(Event & event, size_t id, size_t key) {
+    std::shared_ptr<EventHandler> dispatch = getDispatch(id);
+    if (dispatch)
+        dispatch->callEvent(event, key);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::emitEventKeyedAsync} /////////////////////
+/////////////////////////////////////////////////////////////////
+void EventManager::emitEventKeyedAsync(std::shared_ptr<Event> event, size_t id, size_t key) {
+    EventQueue::Entry * entry = new EventQueue::Entry(event, id);
+    entry->route = key;
+    entry->isRouted = true;
+    pushEventAsync(entry);
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see EventManager::emitEventAsync} //////////////////////////
 /////////////////////////////////////////////////////////////////
 void EventManager::emitEventAsync(std::shared_ptr<Event> event, size_t id) {
-    Delegate<void ()> delegate([=]() mutable {
-        emitEvent(*event, id);
-    });
-    GhrumAPI::getScheduler().asyncAnonymousTask(delegate);
+    pushEventAsync(new EventQueue::Entry(event, id));
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see EventManager::emitEventAsync} //////////////////////////
 /////////////////////////////////////////////////////////////////
 void EventManager::emitEventAsync(std::shared_ptr<Event> event, EventDelegate function, size_t id) {
-    Delegate<void ()> delegate([=]() mutable {
-        emitEvent(*event, id);
-        function(*event);
+    EventQueue::Entry * entry = new EventQueue::Entry(event, id);
+    entry->function = function;
+    entry->isCompletion = true;
+    pushEventAsync(entry);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::emitEventCoalesced} //////////////////////
+/////////////////////////////////////////////////////////////////
+void EventManager::emitEventCoalesced(std::shared_ptr<Event> event, size_t id, size_t key) {
+    EventQueue::Entry * entry = new EventQueue::Entry(event, id);
+    entry->key = key;
+    entry->isCoalesced = true;
+    pushEventAsync(entry);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::emitEventOrdered} ////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventManager::emitEventOrdered(std::shared_ptr<Event> event, size_t id, size_t key) {
+    EventQueue::Entry * entry = new EventQueue::Entry(event, id);
+    entry->order = key;
+    entry->isOrdered = true;
+    pushEventAsync(entry);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::postEvent} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+bool EventManager::postEvent(std::shared_ptr<Event> event, size_t id) {
+    // Reserve a place in the queue first, so the length never goes
+    // beyond the capacity.
+    if (postedLength_.fetch_add(1, std::memory_order_relaxed) >= EVENT_POST_CAPACITY) {
+        postedLength_.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // The queue is drained by the main thread on every tick, so there
+    // is no need to schedule a drain.
+    posted_.push(new EventQueue::Entry(event, id));
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::getPostedLength} /////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t EventManager::getPostedLength() {
+    return postedLength_.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::emitPostedEvents} ////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventManager::emitPostedEvents() {
+    size_t length = 0;
+    EventQueue::Entry * entry = posted_.pop();
+    while (entry != nullptr) {
+        EventQueue::Entry * next = entry->next;
+        try {
+            emitEventShared(entry->event, entry->id, nullptr, true, nullptr);
+        } catch (std::exception & ex) {
+            BOOST_LOG_TRIVIAL(warning)
+                    << "[!!] <EventManager> Listener has trigger an exception: " << ex.what();
+        }
+        delete entry;
+        entry = next;
+        length++;
+    }
+    postedLength_.fetch_sub(length, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::pushEventAsync} //////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventManager::pushEventAsync(EventQueue::Entry * entry) {
+    // Ordering keys are often sequential or aligned ids, so they are
+    // mixed before being spread into the lanes.
+    EventQueue & queue = (entry->isOrdered
+                          ? lane_[EventQueue::mix(entry->order) % EVENT_LANE_COUNT]
+                          : queue_[entry->id % EVENT_QUEUE_COUNT]);
+
+    // Only the first event of a batch goes through the scheduler, the
+    // rest of them are emitted by the same drain.
+    if (queue.push(entry)) {
+        scheduleEventAsync(queue);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::scheduleEventAsync} //////////////////////
+/////////////////////////////////////////////////////////////////
+void EventManager::scheduleEventAsync(EventQueue & queue) {
+    Delegate<void ()> delegate([this, &queue]() {
+        drainEventAsync(queue);
     });
     GhrumAPI::getScheduler().asyncAnonymousTask(delegate);
 }
 
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::drainEventAsync} /////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventManager::drainEventAsync(EventQueue & queue) {
+    size_t length = 0;
+    do {
+        // A steady producer must not keep a worker forever, once the
+        // drain has emitted enough the queue is handed to another task.
+        if (length >= EVENT_DRAIN_LENGTH) {
+            scheduleEventAsync(queue);
+            return;
+        }
+
+        EventQueue::Entry * entry = queue.pop();
+        while (entry != nullptr) {
+            EventQueue::Entry * next = entry->next;
+
+            // A listener that throws must not stall the rest of the
+            // batch, since the queue is not drained until it returns.
+            try {
+                emitEventShared(entry->event, entry->id, entry->isRouted ? &entry->route : nullptr,
+                                entry->isOrdered, entry->isCompletion ? &entry->function : nullptr);
+            } catch (std::exception & ex) {
+                BOOST_LOG_TRIVIAL(warning)
+                        << "[!!] <EventManager> Listener has trigger an exception: " << ex.what();
+            }
+            delete entry;
+            entry = next;
+            length++;
+        }
+    } while (queue.release());
+}
+
 /////////////////////////////////////////////////////////////////
 // {@see EventManager::remove} //////////////////////////////////
 /////////////////////////////////////////////////////////////////
@@ -58,18 +239,49 @@ void EventManager::remove(IPlugin & owner) {
     boost::mutex::scoped_lock lock(mutex_);
     // =================== Lock ===================
 
-    if (plugin_.count(owner.getId()) == 0) {
+    std::unordered_map<size_t, std::vector<Handle>>::iterator it
+            = plugin_.find(owner.getId());
+    if (it == plugin_.end()) {
         return;
     }
-    std::vector<ListTuple> tuples = plugin_[owner.getId()];
+    std::set<size_t> events;
+    std::unordered_set<size_t> keys;
+
+    // Every registration of the index that belongs to the plugin
+    // shares a bucket with the rest of its registrations, so each
+    // bucket is only visited once.
+    for (Handle & handle : it->second) {
+        Registration & registration = *handle.second;
+        keys.insert(getIndexKey(handle.first, registration.owner, registration.priority, registration.key,
+                                registration.isKeyed));
+    }
+    for (size_t key : keys) {
+        std::pair<RegistrationIndex::iterator, RegistrationIndex::iterator> range
+            = index_.equal_range(key);
+        while (range.first != range.second) {
+            if (range.first->second->owner == owner.getId())
+                range.first = index_.erase(range.first);
+            else
+                range.first++;
+        }
+    }
+
+    // Remove the delegates of the plugin, each handle points directly
+    // to its registration.
+    for (Handle & handle : it->second) {
+        RegistrationList & registrations = handler_[handle.first];
+        registrations.erase(handle.second);
+        if (registrations.empty())
+            handler_.erase(handle.first);
+        events.insert(handle.first);
+    }
+    plugin_.erase(it);
 
-    // Remove the delegates of the plugin
-    for (ListTuple & tuple : tuples) {
-        const std::unique_ptr<EventHandler> & handler
-            = handler_[std::get<2>(tuple)];
-        handler->removeDelegate( std::get<0>(tuple), std::get<1>(tuple) );
+    // Rebuild the dispatch handler of every event touched.
+    for (size_t id : events) {
+        rebuildDispatch(id);
     }
-    plugin_.erase(owner.getId());
+    publishDispatch();
 }
 
 /////////////////////////////////////////////////////////////////
@@ -82,6 +294,12 @@ void EventManager::removeAll() {
 
     plugin_.clear();
     handler_.clear();
+    index_.clear();
+
+    // Cells are never released, an emitting thread may still hold them.
+    for (auto & it : dispatch_) {
+        std::atomic_store(&it.second->handler, std::shared_ptr<EventHandler>());
+    }
 }
 
 /////////////////////////////////////////////////////////////////
@@ -89,10 +307,21 @@ void EventManager::removeAll() {
 /////////////////////////////////////////////////////////////////
 bool EventManager::addListener(IPlugin & owner, EventListener & listener) {
     std::vector<EventListener::Callback> callbacks = listener.getCallback();
+    std::set<size_t> events;
+
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+
     for (EventListener::Callback & callback : callbacks ) {
-        addDelegate(owner, std::get<2>(callback), std::get<0>(callback),
-                    std::get<1>(callback));
+        if (insertDelegate(owner, std::get<2>(callback), std::get<0>(callback),
+                           std::get<1>(callback), 0, false))
+            events.insert(std::get<1>(callback));
+    }
+    for (size_t id : events) {
+        rebuildDispatch(id);
     }
+    publishDispatch();
     return true;
 }
 
@@ -101,10 +330,21 @@ bool EventManager::addListener(IPlugin & owner, EventListener & listener) {
 /////////////////////////////////////////////////////////////////
 bool EventManager::removeListener(IPlugin & owner, EventListener & listener) {
     std::vector<EventListener::Callback> callbacks = listener.getCallback();
+    std::set<size_t> events;
+
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+
     for (EventListener::Callback & callback : callbacks ) {
-        removeDelegate(owner, std::get<2>(callback), std::get<0>(callback),
-                       std::get<1>(callback));
+        if (eraseDelegate(owner, std::get<2>(callback), std::get<0>(callback),
+                          std::get<1>(callback), 0, false))
+            events.insert(std::get<1>(callback));
+    }
+    for (size_t id : events) {
+        rebuildDispatch(id);
     }
+    publishDispatch();
     return true;
 }
 
@@ -116,13 +356,10 @@ bool EventManager::addDelegate(IPlugin & owner, EventDelegate & callback, EventP
     boost::mutex::scoped_lock lock(mutex_);
     // =================== Lock ===================
 
-    std::unique_ptr<EventHandler> & handler = handler_[id];
-    if (!handler) {
-        handler = std::unique_ptr<EventHandler>(new EventHandler());
-    }
-    bool isHandled = handler->addDelegate(callback, priority);
+    bool isHandled = insertDelegate(owner, callback, priority, id, 0, false);
     if (isHandled) {
-        plugin_[owner.getId()].push_back(std::make_tuple(callback, priority, id));
+        rebuildDispatch(id);
+        publishDispatch();
     }
     return isHandled;
 }
@@ -135,16 +372,264 @@ bool EventManager::removeDelegate(IPlugin & owner, EventDelegate & callback, Eve
     boost::mutex::scoped_lock lock(mutex_);
     // =================== Lock ===================
 
-    std::unordered_map<size_t, std::unique_ptr<EventHandler>>::iterator it
-            = handler_.find(id);
-    if (it == handler_.end()) {
+    bool isRemoved = eraseDelegate(owner, callback, priority, id, 0, false);
+    if (isRemoved) {
+        rebuildDispatch(id);
+        publishDispatch();
+    }
+    return isRemoved;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::addKeyedDelegate} ////////////////////////
+/////////////////////////////////////////////////////////////////
+bool EventManager::addKeyedDelegate(IPlugin & owner, EventDelegate & callback, EventPriority priority, size_t id,
+                                    size_t key) {
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+
+    bool isHandled = insertDelegate(owner, callback, priority, id, key, true);
+    if (isHandled) {
+        rebuildDispatch(id);
+        publishDispatch();
+    }
+    return isHandled;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::removeKeyedDelegate} /////////////////////
+/////////////////////////////////////////////////////////////////
+bool EventManager::removeKeyedDelegate(IPlugin & owner, EventDelegate & callback, EventPriority priority, size_t id,
+                                       size_t key) {
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+
+    bool isRemoved = eraseDelegate(owner, callback, priority, id, key, true);
+    if (isRemoved) {
+        rebuildDispatch(id);
+        publishDispatch();
+    }
+    return isRemoved;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::insertDelegate} //////////////////////////
+/////////////////////////////////////////////////////////////////
+bool EventManager::insertDelegate(IPlugin & owner, EventDelegate & callback, EventPriority priority, size_t id,
+                                  size_t key, bool isKeyed) {
+    if (findDelegate(id, owner.getId(), callback, priority, key, isKeyed) != index_.end()) {
+        return false;
+    }
+
+    // Link the registration and its handle to each other, so any of
+    // them can be removed without searching for the other.
+    RegistrationList & registrations = handler_[id];
+    std::vector<Handle> & handles = plugin_[owner.getId()];
+    Registration registration = { callback, priority, id, owner.getId(), key, handles.size(), isKeyed };
+    registrations.push_back(registration);
+    handles.push_back(Handle(id, --registrations.end()));
+    index_.emplace(getIndexKey(id, owner.getId(), priority, key, isKeyed), --registrations.end());
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::eraseDelegate} ///////////////////////////
+/////////////////////////////////////////////////////////////////
+bool EventManager::eraseDelegate(IPlugin & owner, EventDelegate & callback, EventPriority priority, size_t id,
+                                 size_t key, bool isKeyed) {
+    RegistrationIndex::iterator position = findDelegate(id, owner.getId(), callback, priority, key, isKeyed);
+    if (position == index_.end()) {
         return false;
     }
-    const std::unique_ptr<EventHandler> & handler = it->second;
+    RegistrationList::iterator registration = position->second;
+    index_.erase(position);
 
-    bool isRemoved = handler->removeDelegate(callback, priority);
-    if (isRemoved && handler->isEmpty()) {
-        handler_.erase(id);
+    // Remove the handle of the owner by moving the last handle
+    // into its position.
+    std::vector<Handle> & handles = plugin_[registration->owner];
+    if (registration->index != handles.size() - 1) {
+        handles[registration->index] = handles.back();
+        handles[registration->index].second->index = registration->index;
+    }
+    handles.pop_back();
+    if (handles.empty()) {
+        plugin_.erase(registration->owner);
+    }
+
+    std::unordered_map<size_t, RegistrationList>::iterator it
+            = handler_.find(id);
+    it->second.erase(registration);
+    if (it->second.empty()) {
+        handler_.erase(it);
     }
     return true;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::getIndexKey} /////////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t EventManager::getIndexKey(size_t id, size_t owner, EventPriority priority, size_t key, bool isKeyed) {
+    size_t hash = EventQueue::mix(id);
+    hash = EventQueue::mix(hash ^ owner);
+    hash = EventQueue::mix(hash ^ key);
+    return EventQueue::mix(hash ^ ((size_t) priority << 1 | isKeyed));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::findDelegate} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+EventManager::RegistrationIndex::iterator EventManager::findDelegate(size_t id, size_t owner,
+        const EventDelegate & callback, EventPriority priority, size_t key, bool isKeyed) {
+    // Only the delegates of the same owner, priority and key share a
+    // bucket, the rest of the index is never visited.
+    std::pair<RegistrationIndex::iterator, RegistrationIndex::iterator> range
+        = index_.equal_range(getIndexKey(id, owner, priority, key, isKeyed));
+    for (RegistrationIndex::iterator it = range.first; it != range.second; ++it) {
+        Registration & registration = *it->second;
+        if (registration.id == id && registration.owner == owner && registration.priority == priority
+                && registration.key == key && registration.isKeyed == isKeyed && registration.function == callback)
+            return it;
+    }
+    return index_.end();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::getMetrics} //////////////////////////////
+/////////////////////////////////////////////////////////////////
+EventMetrics & EventManager::getMetrics() {
+    return metrics_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::setParent} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+bool EventManager::setParent(size_t id, size_t parent) {
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+
+    // An event cannot be an ancestor of itself.
+    for (size_t ancestor = parent;;) {
+        if (ancestor == id) {
+            return false;
+        }
+        std::unordered_map<size_t, size_t>::iterator it = parent_.find(ancestor);
+        if (it == parent_.end())
+            break;
+        ancestor = it->second;
+    }
+
+    // Unlink the event from its previous parent.
+    std::unordered_map<size_t, size_t>::iterator it = parent_.find(id);
+    if (it != parent_.end()) {
+        std::vector<size_t> & children = children_[it->second];
+        children.erase(std::remove(children.begin(), children.end(), id), children.end());
+    }
+    parent_[id] = parent;
+    children_[parent].push_back(id);
+
+    rebuildDispatch(id);
+    publishDispatch();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::rebuildDispatch} /////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventManager::rebuildDispatch(size_t id) {
+    // Flatten the delegates of the event and every ancestor, so emitting
+    // an event is always a single lookup.
+    std::shared_ptr<EventHandler> dispatch = std::make_shared<EventHandler>(id, metrics_);
+    std::vector<size_t> descendants;
+    for (size_t ancestor = id;;) {
+        std::unordered_map<size_t, RegistrationList>::iterator it
+                = handler_.find(ancestor);
+        if (it != handler_.end()) {
+            for (Registration & registration : it->second) {
+                // A delegate connected to a descendant as well is
+                // only called once.
+                bool isDuplicated = false;
+                for (size_t descendant : descendants) {
+                    isDuplicated = (findDelegate(descendant, registration.owner, registration.function,
+                                                 registration.priority, registration.key, registration.isKeyed)
+                                    != index_.end());
+                    if (isDuplicated)
+                        break;
+                }
+                if (isDuplicated)
+                    continue;
+
+                if (registration.isKeyed)
+                    dispatch->addDelegate(registration.function, registration.priority, registration.owner,
+                                          registration.key);
+                else
+                    dispatch->addDelegate(registration.function, registration.priority, registration.owner);
+            }
+        }
+
+        std::unordered_map<size_t, size_t>::iterator parent = parent_.find(ancestor);
+        if (parent == parent_.end())
+            break;
+        descendants.push_back(ancestor);
+        ancestor = parent->second;
+    }
+    if (dispatch->isEmpty())
+        dispatch.reset();
+
+    // Emitting threads keep the handler they loaded until they are
+    // done with it, the previous handler is released after them.
+    std::unique_ptr<DispatchCell> & cell = dispatch_[id];
+    if (!cell) {
+        cell = std::unique_ptr<DispatchCell>(new DispatchCell());
+        isDispatchChanged_ = true;
+    }
+    std::atomic_store(&cell->handler, dispatch);
+
+    // Every descendant dispatch the delegates of this event too.
+    std::unordered_map<size_t, std::vector<size_t>>::iterator it
+            = children_.find(id);
+    if (it != children_.end()) {
+        for (size_t child : it->second)
+            rebuildDispatch(child);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::publishDispatch} /////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventManager::publishDispatch() {
+    // Handlers are published through their cell, the index only
+    // changes when an event is dispatched for the first time.
+    if (!isDispatchChanged_) {
+        return;
+    }
+    std::shared_ptr<DispatchMap> snapshot = std::make_shared<DispatchMap>();
+    snapshot->reserve(dispatch_.size());
+    for (auto & it : dispatch_) {
+        snapshot->emplace(it.first, it.second.get());
+    }
+    std::atomic_store(&snapshot_, std::shared_ptr<const DispatchMap>(snapshot));
+    version_.store(++g_DispatchVersion, std::memory_order_release);
+    isDispatchChanged_ = false;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventManager::getDispatch} /////////////////////////////
+/////////////////////////////////////////////////////////////////
+std::shared_ptr<EventHandler> EventManager::getDispatch(size_t id) {
+    static thread_local size_t version = 0;
+    static thread_local std::shared_ptr<const DispatchMap> snapshot;
+
+    // Versions are unique across every manager, so a thread never
+    // keeps the index of another manager. The index only holds the
+    // address of the cells, so keeping it doesn't keep any handler.
+    size_t current = version_.load(std::memory_order_acquire);
+    if (version != current) {
+        snapshot = std::atomic_load(&snapshot_);
+        version = current;
+    }
+    DispatchMap::const_iterator it = snapshot->find(id);
+    return (it != snapshot->end() ? std::atomic_load(&it->second->handler) : std::shared_ptr<EventHandler>());
 }
\ No newline at end of file
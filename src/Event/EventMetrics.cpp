@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Event/EventMetrics.hpp>
+
+using namespace Ghrum;
+
+/**
+ * Emits left before the current thread samples one.
+ */
+static thread_local size_t g_SampleCountdown = 0;
+
+/////////////////////////////////////////////////////////////////
+// {@see EventMetrics::EventMetrics} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+EventMetrics::EventMetrics()
+    : enabled_(false), rate_(1) {
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventMetrics::isEnabled} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+bool EventMetrics::isEnabled() {
+    return enabled_.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventMetrics::setEnabled} //////////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventMetrics::setEnabled(bool isEnabled) {
+    enabled_.store(isEnabled, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventMetrics::setSampleRate} ///////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventMetrics::setSampleRate(size_t rate) {
+    rate_.store(rate > 0 ? rate : 1, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventMetrics::isSampled} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+bool EventMetrics::isSampled() {
+    if (!enabled_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (g_SampleCountdown > 0) {
+        g_SampleCountdown--;
+        return false;
+    }
+    g_SampleCountdown = rate_.load(std::memory_order_relaxed) - 1;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventMetrics::Counter::Counter} ////////////////////////
+/////////////////////////////////////////////////////////////////
+EventMetrics::Counter::Counter(size_t id, EventPriority priority, size_t owner)
+    : id(id), owner(owner), priority(priority), count(0), total(0), maximum(0) {
+    for (size_t i = 0; i < EVENT_METRICS_BUCKET; i++)
+        buckets[i] = 0;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventMetrics::getCounter} //////////////////////////////
+/////////////////////////////////////////////////////////////////
+EventMetrics::Counter & EventMetrics::getCounter(size_t id, EventPriority priority, size_t owner) {
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+
+    std::unique_ptr<Counter> & counter = group_[std::make_tuple(id, (int) priority, owner)];
+    if (!counter)
+        counter = std::unique_ptr<Counter>(new Counter(id, priority, owner));
+    return *counter;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventMetrics::record} //////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventMetrics::record(Counter & counter, uint64_t nanoseconds) {
+    // Find the bucket of the call, which is the position of the
+    // highest bit of the latency.
+    size_t bucket = 63 - __builtin_clzll(nanoseconds | 1);
+    if (bucket >= EVENT_METRICS_BUCKET) {
+        bucket = EVENT_METRICS_BUCKET - 1;
+    }
+    counter.count.fetch_add(1, std::memory_order_relaxed);
+    counter.total.fetch_add(nanoseconds, std::memory_order_relaxed);
+    counter.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t maximum = counter.maximum.load(std::memory_order_relaxed);
+    while (nanoseconds > maximum
+            && !counter.maximum.compare_exchange_weak(maximum, nanoseconds, std::memory_order_relaxed));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventMetrics::getHistograms} ///////////////////////////
+/////////////////////////////////////////////////////////////////
+std::vector<EventMetrics::Histogram> EventMetrics::getHistograms() {
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+
+    // Counters are read while being updated, so a histogram may be
+    // off by the calls recorded meanwhile.
+    std::vector<Histogram> list;
+    for (auto & it : group_) {
+        Counter & counter = *it.second;
+        Histogram histogram;
+        histogram.count = counter.count.load(std::memory_order_relaxed);
+        if (histogram.count == 0)
+            continue;
+        histogram.id = counter.id;
+        histogram.owner = counter.owner;
+        histogram.priority = counter.priority;
+        histogram.total = counter.total.load(std::memory_order_relaxed);
+        histogram.maximum = counter.maximum.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < EVENT_METRICS_BUCKET; i++)
+            histogram.buckets[i] = counter.buckets[i].load(std::memory_order_relaxed);
+        list.push_back(histogram);
+    }
+    return list;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventMetrics::reset} ///////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void EventMetrics::reset() {
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+
+    // Dispatch handlers keep their counters, so they are cleared
+    // instead of released.
+    for (auto & it : group_) {
+        Counter & counter = *it.second;
+        counter.count = 0;
+        counter.total = 0;
+        counter.maximum = 0;
+        for (size_t i = 0; i < EVENT_METRICS_BUCKET; i++)
+            counter.buckets[i] = 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Event/EventQueue.hpp>
+#include <algorithm>
+
+using namespace Ghrum;
+
+/////////////////////////////////////////////////////////////////
+// {@see EventQueue::Entry::Entry} //////////////////////////////
+/////////////////////////////////////////////////////////////////
+EventQueue::Entry::Entry(std::shared_ptr<Event> event, size_t id)
+    : event(event), id(id), key(0), route(0), order(0), isCoalesced(false), isCompletion(false),
+      isRouted(false), isOrdered(false), next(nullptr) {
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventQueue::Entry::operator new} ///////////////////////
+/////////////////////////////////////////////////////////////////
+void * EventQueue::Entry::operator new(size_t size) {
+    return EventPool<Entry>::getInstance().allocate(size);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventQueue::Entry::operator delete} ////////////////////
+/////////////////////////////////////////////////////////////////
+void EventQueue::Entry::operator delete(void * block, size_t size) {
+    EventPool<Entry>::getInstance().deallocate(block, size);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventQueue::EventQueue} ////////////////////////////////
+/////////////////////////////////////////////////////////////////
+EventQueue::EventQueue()
+    : head_(nullptr), scheduled_(false), drain_(0), coalescedLength_(0) {
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventQueue::~EventQueue} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+EventQueue::~EventQueue() {
+    Entry * entry = head_.exchange(nullptr);
+    while (entry != nullptr) {
+        Entry * next = entry->next;
+        delete entry;
+        entry = next;
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventQueue::push} //////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+bool EventQueue::push(Entry * entry) {
+    // Link the entry at the head of the list, producers never
+    // block each other.
+    entry->next = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(entry->next, entry,
+                                        std::memory_order_release, std::memory_order_relaxed));
+
+    // Only the producer that flips the flag schedule a drain, the
+    // rest of them will be handled in the same batch.
+    return !scheduled_.exchange(true, std::memory_order_acq_rel);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventQueue::pop} ///////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+EventQueue::Entry * EventQueue::pop() {
+    Entry * entry = head_.exchange(nullptr, std::memory_order_acquire);
+    Entry * first = nullptr;
+    drain_++;
+    coalescedLength_ = 0;
+
+    // The list is linked from the newest to the oldest entry, so
+    // reversing it gives the push order, and the first coalesced entry
+    // found for a key is the latest one.
+    while (entry != nullptr) {
+        Entry * next = entry->next;
+        if (entry->isCoalesced && !insertCoalesced(entry->id, entry->key)) {
+            delete entry;
+        } else {
+            entry->next = first;
+            first = entry;
+        }
+        entry = next;
+    }
+    return first;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventQueue::release} ///////////////////////////////////
+/////////////////////////////////////////////////////////////////
+bool EventQueue::release() {
+    scheduled_.store(false, std::memory_order_release);
+
+    // An entry pushed while the batch was running didn't schedule
+    // any drain, so take the drain back if nobody did it.
+    return head_.load(std::memory_order_acquire) != nullptr
+           && !scheduled_.exchange(true, std::memory_order_acq_rel);
+}
+
+
+/////////////////////////////////////////////////////////////////
+// {@see EventQueue::mix} ///////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t EventQueue::mix(uint64_t value) {
+    // Finalizer of MurmurHash3, every bit of the key reaches every
+    // bit of the result.
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return size_t(value);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see EventQueue::insertCoalesced} ///////////////////////////
+/////////////////////////////////////////////////////////////////
+bool EventQueue::insertCoalesced(size_t id, size_t key) {
+    // The table keeps its capacity between drains, it only grows when
+    // a drain has more keys than any drain before.
+    if ((coalescedLength_ + 1) * 2 > coalesced_.size()) {
+        std::vector<Coalesced> table(std::max<size_t>(64, coalesced_.size() * 2));
+        for (Coalesced & slot : coalesced_) {
+            if (slot.drain != drain_)
+                continue;
+            size_t index = mix(slot.id ^ mix(slot.key)) & (table.size() - 1);
+            while (table[index].drain == drain_)
+                index = (index + 1) & (table.size() - 1);
+            table[index] = slot;
+        }
+        coalesced_.swap(table);
+    }
+
+    size_t mask = coalesced_.size() - 1;
+    for (size_t index = mix(id ^ mix(key)) & mask;; index = (index + 1) & mask) {
+        Coalesced & slot = coalesced_[index];
+        if (slot.drain != drain_) {
+            slot.id = id;
+            slot.key = key;
+            slot.drain = drain_;
+            coalescedLength_++;
+            return true;
+        }
+        if (slot.id == id && slot.key == key)
+            return false;
+    }
+}
\ No newline at end of file
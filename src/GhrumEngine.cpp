@@ -30,6 +30,11 @@ void GhrumEngine::initialize() {
     eventManager_  = std::unique_ptr<EventManager>(new EventManager());
     scheduler_     = std::unique_ptr<Scheduler>(new Scheduler());
 
+    // Emit the events posted to the main thread at the end of
+    // every tick.
+    scheduler_->addTickDelegate(
+        Delegate<void()>(eventManager_.get(), &EventManager::emitPostedEvents));
+
     // Find every plugin available for the current
     // platform mode.
     BOOST_LOG_TRIVIAL(info) << "[*] Searching for plugins.";
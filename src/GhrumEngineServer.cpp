@@ -22,15 +22,28 @@ using namespace Ghrum;
 // {@see GhrumEngineServer::initialize} /////////////////////////
 /////////////////////////////////////////////////////////////////
 void GhrumEngineServer::initialize() {
+    // Build the manager before the plugins are enabled, so they can
+    // listen for sessions.
+    sessionManager_ = std::unique_ptr<SessionManager>(new SessionManager());
+
     // =================== Base Call ==============
     GhrumEngine::initialize();
     // =================== Base Call ==============
+
+    // Write the messages sent during the tick at the end of it, after
+    // the posted events were emitted.
+    scheduler_->addTickDelegate(
+        Delegate<void()>(sessionManager_.get(), &SessionManager::flush));
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see GhrumEngineServer::dispose} ////////////////////////////
 /////////////////////////////////////////////////////////////////
 void GhrumEngineServer::dispose() {
+    // Close every session while the plugins are still loaded, the
+    // reactors call their delegates until they stop.
+    sessionManager_->stop();
+
     // =================== Base Call ==============
     GhrumEngine::dispose();
     // =================== Base Call ==============
@@ -41,4 +54,11 @@ void GhrumEngineServer::dispose() {
 /////////////////////////////////////////////////////////////////
 Platform GhrumEngineServer::getPlatform() {
     return Platform::Server;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see GhrumEngineServer::getSessionManager} //////////////////
+/////////////////////////////////////////////////////////////////
+SessionManager & GhrumEngineServer::getSessionManager() {
+    return *sessionManager_;
 }
\ No newline at end of file
@@ -16,20 +16,46 @@
 
 #include <GhrumEngineServer.hpp>
 #include <GhrumAPI.hpp>
+#include <Network/SessionReplay.hpp>
 #include <boost/program_options.hpp>
 
+/**
+ * Replay a capture through the sessions of the engine, then stop it.
+ *
+ * @param engine the engine
+ * @param path the path of the capture
+ * @param isRealtime if the capture is replayed at its original pace
+ */
+void replay(Ghrum::GhrumEngineServer & engine, const std::string & path, bool isRealtime) {
+    try {
+        Ghrum::SessionReplay replay(engine.getSessionManager(), path);
+        replay.run(isRealtime);
+
+        uint64_t elapsed = std::max<uint64_t>(1, replay.getElapsed());
+        BOOST_LOG_TRIVIAL(info)
+                << "[*] Replayed " << replay.getRecordCount() << " records of "
+                << replay.getSessionCount() << " sessions, " << replay.getByteCount() << " bytes in "
+                << elapsed << " ms (" << (replay.getByteCount() * 1000 / elapsed) << " bytes/s).";
+    } catch (std::exception & ex) {
+        BOOST_LOG_TRIVIAL(error) << ex.what();
+    }
+    static_cast<Ghrum::Scheduler &>(engine.getScheduler()).setCancelled();
+}
+
 /**
  * Initialize and execute the engine.
  *
  * @param mode the mode of the engine
+ * @param vm the arguments of the application
  */
-void run(std::string & mode) {
+void run(std::string & mode, boost::program_options::variables_map & vm) {
     // Initialize and populate the engine class and
     // descriptor, also the global singleton of it.
     std::unique_ptr<Ghrum::GhrumEngine> engine;
+    Ghrum::GhrumEngineServer * server = nullptr;
     if (mode.compare("server") == 0) {
-        engine = std::unique_ptr<Ghrum::GhrumEngine>(
-                     new Ghrum::GhrumEngineServer());
+        server = new Ghrum::GhrumEngineServer();
+        engine = std::unique_ptr<Ghrum::GhrumEngine>(server);
     } else {
         BOOST_LOG_TRIVIAL(error)
                 << "Client mode is not supported yet.";
@@ -40,8 +66,22 @@ void run(std::string & mode) {
     BOOST_LOG_TRIVIAL(info) << "[*] Initializing....";
     engine->initialize();
 
+    // Record or replay the traffic of the sessions, once the plugins
+    // have set up the manager. A replay stops the engine when done.
+    boost::thread replayer;
+    if (server != nullptr && vm.count("capture")) {
+        server->getSessionManager().startCapture(vm["capture"].as<std::string>());
+    }
+    if (server != nullptr && vm.count("replay")) {
+        replayer = boost::thread(&replay, boost::ref(*server), vm["replay"].as<std::string>(),
+                                 vm.count("fast") == 0);
+    }
+
     // Run into the scheduler's main loop.
     static_cast<Ghrum::Scheduler &>(engine->getScheduler()).runMainThread();
+    if (replayer.joinable()) {
+        replayer.join();
+    }
 
     // Dispose every engine's component allocated.
     BOOST_LOG_TRIVIAL(info) << "[*] Exiting....";
@@ -61,7 +101,12 @@ int main(int argc, char * argv[]) {
 
     description.add_options()
     ("help,h", "Show help message.")
-    ("mode,m", boost::program_options::value<std::string>(), "Sets the mode of the engine.");
+    ("mode,m", boost::program_options::value<std::string>(), "Sets the mode of the engine.")
+    ("capture,c", boost::program_options::value<std::string>(),
+     "Records the bytes received by every session into a file.")
+    ("replay,r", boost::program_options::value<std::string>(),
+     "Replays a capture through the sessions, then exits.")
+    ("fast,f", "Replays the capture as fast as possible, not at its original pace.");
 
     try {
         boost::program_options::store(
@@ -71,7 +116,7 @@ int main(int argc, char * argv[]) {
         if ( vm.count("mode") ) {
             std::string mode
                 = vm["mode"].as<std::string>();
-            run(mode);
+            run(mode, vm);
         } else {
             std::cout << description << std::endl;
         }
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Network/MessageAllocator.hpp>
+#include <algorithm>
+#include <new>
+#include <vector>
+
+using namespace Ghrum;
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::Cache} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+struct MessageAllocator::Cache {
+    Cache(MessageAllocator & allocator)
+        : allocator(allocator) {
+        for (size_t i = 0; i < MESSAGE_ALLOCATOR_CLASSES; i++) {
+            limit[i] = MESSAGE_ALLOCATOR_CACHE / (MESSAGE_ALLOCATOR_MINIMUM << i);
+            block[i].reserve(limit[i]);
+        }
+    }
+
+    ~Cache();
+
+    MessageAllocator & allocator;
+    size_t limit[MESSAGE_ALLOCATOR_CLASSES];
+    std::vector<int8_t *> block[MESSAGE_ALLOCATOR_CLASSES];
+};
+
+/**
+ * Flag of a thread whose cache was destroyed, a buffer released after
+ * it goes straight to the shared pool.
+ */
+static thread_local bool g_IsCacheClosed = false;
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::Cache::~Cache} ///////////////////////
+/////////////////////////////////////////////////////////////////
+MessageAllocator::Cache::~Cache() {
+    g_IsCacheClosed = true;
+
+    // The blocks of a thread that exits are given to the other threads.
+    for (size_t i = 0; i < MESSAGE_ALLOCATOR_CLASSES; i++) {
+        for (int8_t * entry : block[i]) {
+            allocator.doDeallocate(entry, i, MESSAGE_ALLOCATOR_MINIMUM << i);
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::getInstance} /////////////////////////
+/////////////////////////////////////////////////////////////////
+MessageAllocator & MessageAllocator::getInstance() {
+    static MessageAllocator * instance = new MessageAllocator(MESSAGE_ALLOCATOR_LIMIT);
+    return *instance;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::MessageAllocator} ////////////////////
+/////////////////////////////////////////////////////////////////
+MessageAllocator::MessageAllocator(size_t limit)
+    : used_(0), held_(0), peak_(0), limit_(limit), hits_(0), misses_(0), failures_(0) {
+    for (size_t i = 0; i < MESSAGE_ALLOCATOR_CLASSES; i++) {
+        shared_[i] = std::unique_ptr<boost::lockfree::stack<int8_t *>>(
+                         new boost::lockfree::stack<int8_t *>(
+                             std::max<size_t>(1, MESSAGE_ALLOCATOR_SHARED / (MESSAGE_ALLOCATOR_MINIMUM << i))));
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::~MessageAllocator} ///////////////////
+/////////////////////////////////////////////////////////////////
+MessageAllocator::~MessageAllocator() {
+    int8_t * block;
+    for (size_t i = 0; i < MESSAGE_ALLOCATOR_CLASSES; i++) {
+        while (shared_[i]->pop(block))
+            delete[] block;
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::allocate} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+int8_t * MessageAllocator::allocate(size_t & capacity) {
+    size_t index = getClass(capacity);
+    size_t size = (index < MESSAGE_ALLOCATOR_CLASSES ? MESSAGE_ALLOCATOR_MINIMUM << index : capacity);
+
+    // The limit is checked only when a block is taken from the heap, a
+    // free block is already held.
+    size_t used = used_.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = peak_.load(std::memory_order_relaxed);
+    while (peak < used && !peak_.compare_exchange_weak(peak, used, std::memory_order_relaxed));
+    capacity = size;
+
+    Cache * cache = (index < MESSAGE_ALLOCATOR_CLASSES ? getCache() : nullptr);
+    if (cache != nullptr && !cache->block[index].empty()) {
+        int8_t * block = cache->block[index].back();
+        cache->block[index].pop_back();
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return block;
+    }
+
+    try {
+        return doAllocate(index, size);
+    } catch (std::bad_alloc &) {
+        used_.fetch_sub(size, std::memory_order_relaxed);
+        failures_.fetch_add(1, std::memory_order_relaxed);
+        throw;
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::deallocate} //////////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageAllocator::deallocate(int8_t * block, size_t capacity) {
+    size_t index = getClass(capacity);
+    used_.fetch_sub(capacity, std::memory_order_relaxed);
+
+    Cache * cache = (index < MESSAGE_ALLOCATOR_CLASSES ? getCache() : nullptr);
+    if (cache != nullptr && cache->block[index].size() < cache->limit[index]) {
+        cache->block[index].push_back(block);
+        return;
+    }
+    doDeallocate(block, index, capacity);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::getStatistics} ///////////////////////
+/////////////////////////////////////////////////////////////////
+MessageAllocator::Statistics MessageAllocator::getStatistics() {
+    Statistics statistics;
+    statistics.hits = hits_.load(std::memory_order_relaxed);
+    statistics.misses = misses_.load(std::memory_order_relaxed);
+    statistics.failures = failures_.load(std::memory_order_relaxed);
+    statistics.used = used_.load(std::memory_order_relaxed);
+    statistics.held = held_.load(std::memory_order_relaxed);
+    statistics.peak = peak_.load(std::memory_order_relaxed);
+    statistics.limit = limit_.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::setLimit} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageAllocator::setLimit(size_t limit) {
+    limit_ = limit;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::getClass} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t MessageAllocator::getClass(size_t capacity) {
+    size_t index = 0;
+    size_t size = MESSAGE_ALLOCATOR_MINIMUM;
+    while (size < capacity && index < MESSAGE_ALLOCATOR_CLASSES) {
+        size <<= 1;
+        index++;
+    }
+    return index;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::getCache} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+MessageAllocator::Cache * MessageAllocator::getCache() {
+    // Only the blocks of the allocator of the process are cached by
+    // each thread, and none once the thread is exiting.
+    if (g_IsCacheClosed || this != &getInstance()) {
+        return nullptr;
+    }
+    static thread_local Cache cache(*this);
+    return &cache;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::doAllocate} //////////////////////////
+/////////////////////////////////////////////////////////////////
+int8_t * MessageAllocator::doAllocate(size_t index, size_t size) {
+    int8_t * block;
+    if (index < MESSAGE_ALLOCATOR_CLASSES && shared_[index]->pop(block)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return block;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    if (!doReserve(size)) {
+        throw std::bad_alloc();
+    }
+    try {
+        return new int8_t[size];
+    } catch (std::bad_alloc &) {
+        held_.fetch_sub(size, std::memory_order_relaxed);
+        throw;
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::doDeallocate} ////////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageAllocator::doDeallocate(int8_t * block, size_t index, size_t size) {
+    if (index >= MESSAGE_ALLOCATOR_CLASSES || !shared_[index]->bounded_push(block)) {
+        delete[] block;
+        held_.fetch_sub(size, std::memory_order_relaxed);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageAllocator::doReserve} ///////////////////////////
+/////////////////////////////////////////////////////////////////
+bool MessageAllocator::doReserve(size_t size) {
+    // The bytes are reserved before the block is taken, so the limit
+    // holds even with many threads allocating at the same time.
+    if (held_.fetch_add(size, std::memory_order_relaxed) + size <= limit_.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    held_.fetch_sub(size, std::memory_order_relaxed);
+    if (size > limit_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    // The free blocks of the shared pool are given back, the largest
+    // first, until the bytes fit. The caches of the threads are theirs.
+    int8_t * block;
+    for (size_t i = MESSAGE_ALLOCATOR_CLASSES; i-- > 0;) {
+        while (shared_[i]->pop(block)) {
+            delete[] block;
+            held_.fetch_sub(MESSAGE_ALLOCATOR_MINIMUM << i, std::memory_order_relaxed);
+            if (held_.fetch_add(size, std::memory_order_relaxed) + size <= limit_.load(std::memory_order_relaxed)) {
+                return true;
+            }
+            held_.fetch_sub(size, std::memory_order_relaxed);
+        }
+    }
+    return false;
+}
\ No newline at end of file
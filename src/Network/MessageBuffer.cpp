@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Network/MessageBuffer.hpp>
+#include <Network/MessageAllocator.hpp>
+#include <cstring>
+
+using namespace Ghrum;
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBuffer::MessageBuffer} //////////////////////////
+/////////////////////////////////////////////////////////////////
+MessageBuffer::MessageBuffer(size_t capacity)
+    : capacity_(capacity), read_(0), write_(0) {
+    data_ = MessageAllocator::getInstance().allocate(capacity_);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBuffer::MessageBuffer} //////////////////////////
+/////////////////////////////////////////////////////////////////
+MessageBuffer::MessageBuffer(MessageBuffer && other)
+    : data_(other.data_), capacity_(other.capacity_), read_(other.read_), write_(other.write_) {
+    other.data_ = nullptr;
+    other.capacity_ = other.read_ = other.write_ = 0;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBuffer::~MessageBuffer} /////////////////////////
+/////////////////////////////////////////////////////////////////
+MessageBuffer::~MessageBuffer() {
+    if (data_ != nullptr) {
+        MessageAllocator::getInstance().deallocate(data_, capacity_);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBuffer::operator=} //////////////////////////////
+/////////////////////////////////////////////////////////////////
+MessageBuffer & MessageBuffer::operator=(MessageBuffer && other) {
+    std::swap(data_, other.data_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(read_, other.read_);
+    std::swap(write_, other.write_);
+    return *this;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBuffer::prepare} ////////////////////////////////
+/////////////////////////////////////////////////////////////////
+int8_t * MessageBuffer::prepare(size_t length) {
+    if (capacity_ - write_ >= length) {
+        return data_ + write_;
+    }
+
+    // Move the unread bytes to the front when that makes enough room,
+    // otherwise grow the buffer geometrically.
+    size_t unread = write_ - read_;
+    if (capacity_ - unread >= length) {
+        std::memmove(data_, data_ + read_, unread);
+    } else {
+        size_t capacity = (capacity_ > 0 ? capacity_ * 2 : MESSAGE_BUFFER_CAPACITY);
+        while (capacity - unread < length) {
+            capacity *= 2;
+        }
+        MessageAllocator & allocator = MessageAllocator::getInstance();
+        int8_t * data = allocator.allocate(capacity);
+        if (data_ != nullptr) {
+            std::memcpy(data, data_ + read_, unread);
+            allocator.deallocate(data_, capacity_);
+        }
+        data_ = data;
+        capacity_ = capacity;
+    }
+    read_ = 0;
+    write_ = unread;
+    return data_ + write_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBuffer::write} //////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageBuffer::write(const int8_t * data, size_t length) {
+    std::memcpy(prepare(length), data, length);
+    commit(length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBuffer::clear} //////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageBuffer::clear() {
+    read_ = write_ = 0;
+}
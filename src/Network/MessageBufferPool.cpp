@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Network/MessageBufferPool.hpp>
+
+using namespace Ghrum;
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBufferPool::getInstance} ////////////////////////
+/////////////////////////////////////////////////////////////////
+MessageBufferPool & MessageBufferPool::getInstance() {
+    static MessageBufferPool * instance = new MessageBufferPool(MESSAGE_BUFFER_POOL_CAPACITY);
+    return *instance;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBufferPool::MessageBufferPool} //////////////////
+/////////////////////////////////////////////////////////////////
+MessageBufferPool::MessageBufferPool(size_t capacity)
+    : free_(capacity) {
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBufferPool::~MessageBufferPool} /////////////////
+/////////////////////////////////////////////////////////////////
+MessageBufferPool::~MessageBufferPool() {
+    MessageBuffer * buffer;
+    while (free_.pop(buffer))
+        delete buffer;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBufferPool::acquire} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+MessageBuffer * MessageBufferPool::acquire() {
+    MessageBuffer * buffer;
+    if (free_.pop(buffer)) {
+        return buffer;
+    }
+    return new MessageBuffer();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBufferPool::release} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageBufferPool::release(MessageBuffer * buffer) {
+    buffer->clear();
+    if (buffer->getCapacity() > MESSAGE_BUFFER_POOL_LIMIT || !free_.bounded_push(buffer)) {
+        delete buffer;
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageBufferPool::share} //////////////////////////////
+/////////////////////////////////////////////////////////////////
+std::shared_ptr<const MessageBuffer> MessageBufferPool::share(MessageBuffer * buffer) {
+    return std::shared_ptr<const MessageBuffer>(buffer, [this](const MessageBuffer * buffer) {
+        release(const_cast<MessageBuffer *>(buffer));
+    });
+}
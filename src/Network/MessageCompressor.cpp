@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Network/MessageCompressor.hpp>
+#include <zlib.h>
+#include <new>
+#include <stdexcept>
+
+#ifdef _GHRUM_USE_LZ4
+#include <lz4.h>
+#endif
+
+using namespace Ghrum;
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageCompressor::getInstance} ////////////////////////
+/////////////////////////////////////////////////////////////////
+MessageCompressor & MessageCompressor::getInstance() {
+    // Every reactor compresses with its own contexts, so they are
+    // never shared between threads.
+    static thread_local MessageCompressor instance;
+    return instance;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageCompressor::isSupported} ////////////////////////
+/////////////////////////////////////////////////////////////////
+bool MessageCompressor::isSupported(MessageCompression compression) {
+#ifdef _GHRUM_USE_LZ4
+    return true;
+#else
+    return compression != MessageCompression::Lz4;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageCompressor::MessageCompressor} //////////////////
+/////////////////////////////////////////////////////////////////
+MessageCompressor::MessageCompressor()
+    : deflate_(new z_stream()), inflate_(new z_stream()) {
+    if (deflateInit(deflate_.get(), MESSAGE_COMPRESSION_ZLIB_LEVEL) != Z_OK) {
+        throw std::bad_alloc();
+    }
+    if (inflateInit(inflate_.get()) != Z_OK) {
+        deflateEnd(deflate_.get());
+        throw std::bad_alloc();
+    }
+#ifdef _GHRUM_USE_LZ4
+    lz4_ = std::unique_ptr<char[]>(new char[LZ4_sizeofState()]);
+#endif
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageCompressor::~MessageCompressor} /////////////////
+/////////////////////////////////////////////////////////////////
+MessageCompressor::~MessageCompressor() {
+    deflateEnd(deflate_.get());
+    inflateEnd(inflate_.get());
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageCompressor::getBound} ///////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t MessageCompressor::getBound(MessageCompression compression, size_t length) {
+    switch (compression) {
+#ifdef _GHRUM_USE_LZ4
+    case MessageCompression::Lz4:
+        return LZ4_compressBound(int(length));
+#endif
+    case MessageCompression::Zlib:
+        return deflateBound(deflate_.get(), uLong(length));
+    default:
+        throw std::invalid_argument("Compression not supported");
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageCompressor::compress} ///////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t MessageCompressor::compress(MessageCompression compression, const int8_t * data, size_t length,
+                                   int8_t * output) {
+    switch (compression) {
+#ifdef _GHRUM_USE_LZ4
+    case MessageCompression::Lz4:
+        return size_t(LZ4_compress_fast_extState(lz4_.get(), reinterpret_cast<const char *>(data),
+                      reinterpret_cast<char *>(output), int(length), LZ4_compressBound(int(length)), 1));
+#endif
+    case MessageCompression::Zlib: {
+        // A reset keeps the memory of the context, only its state is
+        // cleared.
+        z_stream & stream = *deflate_;
+        deflateReset(&stream);
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<int8_t *>(data));
+        stream.avail_in = uInt(length);
+        stream.next_out = reinterpret_cast<Bytef *>(output);
+        stream.avail_out = uInt(deflateBound(&stream, uLong(length)));
+        if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+            throw std::runtime_error("Failed to compress a message");
+        }
+        return size_t(stream.total_out);
+    }
+    default:
+        throw std::invalid_argument("Compression not supported");
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageCompressor::decompress} /////////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageCompressor::decompress(MessageCompression compression, const int8_t * data, size_t length,
+                                   int8_t * output, size_t size) {
+    switch (compression) {
+#ifdef _GHRUM_USE_LZ4
+    case MessageCompression::Lz4:
+        if (LZ4_decompress_safe(reinterpret_cast<const char *>(data), reinterpret_cast<char *>(output),
+                                int(length), int(size)) != int(size)) {
+            throw std::runtime_error("Malformed compressed message");
+        }
+        return;
+#endif
+    case MessageCompression::Zlib: {
+        z_stream & stream = *inflate_;
+        inflateReset(&stream);
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<int8_t *>(data));
+        stream.avail_in = uInt(length);
+        stream.next_out = reinterpret_cast<Bytef *>(output);
+        stream.avail_out = uInt(size);
+        if (inflate(&stream, Z_FINISH) != Z_STREAM_END || stream.total_out != size) {
+            throw std::runtime_error("Malformed compressed message");
+        }
+        return;
+    }
+    default:
+        throw std::invalid_argument("Compression not supported");
+    }
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Network/MessageEndian.hpp>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MESSAGE_ENDIAN_X86
+#include <immintrin.h>
+#endif
+
+using namespace Ghrum;
+
+/**
+ * A type definition of a kernel that copies swapped values.
+ */
+typedef void (*SwapKernel)(int8_t *, const int8_t *, size_t);
+
+/////////////////////////////////////////////////////////////////
+// {@see copyScalar} ////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+template<typename T>
+static void copyScalar(int8_t * destination, const int8_t * source, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        T value;
+        std::memcpy(&value, source + i * sizeof(T), sizeof(T));
+        value = swapBytes(value);
+        std::memcpy(destination + i * sizeof(T), &value, sizeof(T));
+    }
+}
+
+#ifdef MESSAGE_ENDIAN_X86
+
+/////////////////////////////////////////////////////////////////
+// {@see swapVector} ////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+template<size_t N>
+__attribute__((target("sse2")))
+static __m128i swapVector(__m128i value);
+
+template<>
+__attribute__((target("sse2")))
+__m128i swapVector<2>(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+}
+
+template<>
+__attribute__((target("sse2")))
+__m128i swapVector<4>(__m128i value) {
+    // Swap the shorts of each integer, then the bytes of each short.
+    value = _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, 0xB1), 0xB1);
+    return swapVector<2>(value);
+}
+
+template<>
+__attribute__((target("sse2")))
+__m128i swapVector<8>(__m128i value) {
+    // Reverse the shorts of each long, then the bytes of each short.
+    value = _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, 0x1B), 0x1B);
+    return swapVector<2>(value);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see copySSE2} //////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+template<typename T>
+__attribute__((target("sse2")))
+static void copySSE2(int8_t * destination, const int8_t * source, size_t count) {
+    const size_t step = 16 / sizeof(T);
+    size_t i = 0;
+    for (; i + step <= count; i += step) {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * sizeof(T)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i * sizeof(T)), swapVector<sizeof(T)>(value));
+    }
+    copyScalar<T>(destination + i * sizeof(T), source + i * sizeof(T), count - i);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see getShuffle} ////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+template<size_t N>
+__attribute__((target("avx2")))
+static __m256i getShuffle();
+
+template<>
+__attribute__((target("avx2")))
+__m256i getShuffle<2>() {
+    return _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+}
+
+template<>
+__attribute__((target("avx2")))
+__m256i getShuffle<4>() {
+    return _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+}
+
+template<>
+__attribute__((target("avx2")))
+__m256i getShuffle<8>() {
+    return _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see copyAVX2} //////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+template<typename T>
+__attribute__((target("avx2")))
+static void copyAVX2(int8_t * destination, const int8_t * source, size_t count) {
+    // The shuffle works within each 128 bit lane, which holds whole
+    // values of any width.
+    const __m256i shuffle = getShuffle<sizeof(T)>();
+    const size_t step = 32 / sizeof(T);
+    size_t i = 0;
+    for (; i + step <= count; i += step) {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i * sizeof(T)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i * sizeof(T)),
+                            _mm256_shuffle_epi8(value, shuffle));
+    }
+    copyScalar<T>(destination + i * sizeof(T), source + i * sizeof(T), count - i);
+}
+
+#endif // MESSAGE_ENDIAN_X86
+
+/////////////////////////////////////////////////////////////////
+// {@see getKernel} /////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+template<typename T>
+static SwapKernel getKernel() {
+#ifdef MESSAGE_ENDIAN_X86
+    // SSE2 is always available on x86-64, AVX2 must be asked for.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &copyAVX2<T>;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return &copySSE2<T>;
+    }
+#endif
+    return &copyScalar<T>;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see copySwapped} ///////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Ghrum::copySwapped(void * destination, const void * source, size_t count, size_t width) {
+    // Kernels are chosen the first time they are needed, so calls made
+    // during static initialization are safe.
+    static const SwapKernel kernel16 = getKernel<uint16_t>();
+    static const SwapKernel kernel32 = getKernel<uint32_t>();
+    static const SwapKernel kernel64 = getKernel<uint64_t>();
+
+    int8_t * output = static_cast<int8_t *>(destination);
+    const int8_t * input = static_cast<const int8_t *>(source);
+    switch (width) {
+    case 2:
+        kernel16(output, input, count);
+        break;
+    case 4:
+        kernel32(output, input, count);
+        break;
+    case 8:
+        kernel64(output, input, count);
+        break;
+    default:
+        std::memcpy(output, input, count * width);
+        break;
+    }
+}
\ No newline at end of file
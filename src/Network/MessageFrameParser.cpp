@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Network/MessageFrameParser.hpp>
+#include <Network/MessageEndian.hpp>
+#include <Network/MessageVarint.hpp>
+#include <cstring>
+#include <stdexcept>
+
+using namespace Ghrum;
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageFrameParser::MessageFrameParser} ////////////////
+/////////////////////////////////////////////////////////////////
+MessageFrameParser::MessageFrameParser(MessageFramePrefix prefix, bool isBigEndianness, size_t limit)
+    : prefix_(prefix), isBigEndianness_(isBigEndianness), limit_(limit) {
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageFrameParser::getPrefix} /////////////////////////
+/////////////////////////////////////////////////////////////////
+MessageFramePrefix MessageFrameParser::getPrefix() const {
+    return prefix_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageFrameParser::isBigEndianness} ///////////////////
+/////////////////////////////////////////////////////////////////
+bool MessageFrameParser::isBigEndianness() const {
+    return isBigEndianness_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageFrameParser::getLimit} //////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t MessageFrameParser::getLimit() const {
+    return limit_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageFrameParser::next} //////////////////////////////
+/////////////////////////////////////////////////////////////////
+bool MessageFrameParser::next(const int8_t * data, size_t length, size_t & offset, size_t & size) const {
+    uint16_t shortPrefix;
+    uint32_t integerPrefix;
+
+    switch (prefix_) {
+    case MessageFramePrefix::None:
+        offset = 0;
+        size = length;
+        return length > 0;
+    case MessageFramePrefix::Short:
+        if (length < sizeof(shortPrefix)) {
+            return false;
+        }
+        std::memcpy(&shortPrefix, data, sizeof(shortPrefix));
+        offset = sizeof(shortPrefix);
+        size = (isBigEndianness_ != MESSAGE_HOST_BIG_ENDIAN ? swapBytes(shortPrefix) : shortPrefix);
+        break;
+    case MessageFramePrefix::Integer:
+        if (length < sizeof(integerPrefix)) {
+            return false;
+        }
+        std::memcpy(&integerPrefix, data, sizeof(integerPrefix));
+        offset = sizeof(integerPrefix);
+        size = (isBigEndianness_ != MESSAGE_HOST_BIG_ENDIAN ? swapBytes(integerPrefix) : integerPrefix);
+        break;
+    case MessageFramePrefix::Varint:
+        offset = decodeVarint(data, length, integerPrefix);
+        if (offset == 0) {
+            return false;
+        }
+        size = integerPrefix;
+        break;
+    }
+
+    if (size > limit_) {
+        throw std::length_error("Frame longer than the limit");
+    }
+    return length - offset >= size;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageFrameParser::encode} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t MessageFrameParser::encode(int8_t * data, size_t size) const {
+    uint16_t shortPrefix;
+    uint32_t integerPrefix;
+
+    switch (prefix_) {
+    case MessageFramePrefix::None:
+        return 0;
+    case MessageFramePrefix::Short:
+        if (size > UINT16_MAX) {
+            throw std::length_error("Frame longer than its prefix");
+        }
+        shortPrefix = uint16_t(size);
+        shortPrefix = (isBigEndianness_ != MESSAGE_HOST_BIG_ENDIAN ? swapBytes(shortPrefix) : shortPrefix);
+        std::memcpy(data, &shortPrefix, sizeof(shortPrefix));
+        return sizeof(shortPrefix);
+    case MessageFramePrefix::Integer:
+        if (size > UINT32_MAX) {
+            throw std::length_error("Frame longer than its prefix");
+        }
+        integerPrefix = uint32_t(size);
+        integerPrefix = (isBigEndianness_ != MESSAGE_HOST_BIG_ENDIAN ? swapBytes(integerPrefix) : integerPrefix);
+        std::memcpy(data, &integerPrefix, sizeof(integerPrefix));
+        return sizeof(integerPrefix);
+    case MessageFramePrefix::Varint:
+        if (size > UINT32_MAX) {
+            throw std::length_error("Frame longer than its prefix");
+        }
+        return encodeVarint(data, uint32_t(size));
+    }
+    return 0;
+}
@@ -15,14 +15,67 @@
  */
 
 #include <Network/MessageInputStream.hpp>
+#include <Network/MessageEndian.hpp>
+#include <Network/MessageUnicode.hpp>
+#include <Network/MessageVarint.hpp>
+#include <cstring>
+#include <stdexcept>
 
 using namespace Ghrum;
 
 /////////////////////////////////////////////////////////////////
-// {@see MessageInputStream::readBoolean} ///////////////////////
+// {@see MessageInputStream::MessageInputStream} ////////////////
+/////////////////////////////////////////////////////////////////
+MessageInputStream::MessageInputStream(MessageBuffer & buffer)
+    : isBigEndianness_(false), buffer_(&buffer), start_(buffer.getData()), position_(start_),
+      limit_(start_ + buffer.getLength()) {
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::MessageInputStream} ////////////////
+/////////////////////////////////////////////////////////////////
+MessageInputStream::MessageInputStream(const int8_t * data, size_t length)
+    : isBigEndianness_(false), buffer_(nullptr), start_(data), position_(data), limit_(data + length) {
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::~MessageInputStream} ///////////////
 /////////////////////////////////////////////////////////////////
-MessageInputStream::MessageInputStream(std::deque<int8_t> & buffer)
-    : buffer_(buffer) {
+MessageInputStream::~MessageInputStream() {
+    if (buffer_ != nullptr) {
+        buffer_->consume(position_ - start_);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readValue} /////////////////////////
+/////////////////////////////////////////////////////////////////
+template<typename T>
+T MessageInputStream::readValue() {
+    if (size_t(limit_ - position_) < sizeof(T)) {
+        throw std::out_of_range("Not enough bytes to read from the stream");
+    }
+
+    // The bytes aren't aligned, memcpy of a fixed size compiles
+    // into a single unaligned load.
+    T value;
+    std::memcpy(&value, position_, sizeof(T));
+    position_ += sizeof(T);
+    return (isBigEndianness_ != MESSAGE_HOST_BIG_ENDIAN ? swapBytes(value) : value);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readVarint} ////////////////////////
+/////////////////////////////////////////////////////////////////
+template<typename T>
+T MessageInputStream::readVarint() {
+    T value;
+    size_t length = decodeVarint(position_, limit_ - position_, value);
+    if (length == 0) {
+        throw std::out_of_range("Not enough bytes to read from the stream");
+    }
+    position_ += length;
+    return value;
 }
 
 /////////////////////////////////////////////////////////////////
@@ -36,21 +89,18 @@ bool MessageInputStream::readBoolean() {
 // {@see MessageInputStream::readByte} //////////////////////////
 /////////////////////////////////////////////////////////////////
 int8_t MessageInputStream::readByte() {
-    int8_t byte = buffer_.front();
-    buffer_.pop_front();
-    return byte;
+    return int8_t(readValue<uint8_t>());
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see MessageInputStream::readBytes} /////////////////////////
 /////////////////////////////////////////////////////////////////
 size_t MessageInputStream::readBytes(int8_t * buffer, size_t length) {
-    if (buffer_.size() < length) {
-        length = buffer_.size();
-    }
-    for (size_t i = 0; i < length; i++) {
-        buffer[i] = readByte();
+    if (size_t(limit_ - position_) < length) {
+        length = limit_ - position_;
     }
+    std::memcpy(buffer, position_, length);
+    position_ += length;
     return length;
 }
 
@@ -58,55 +108,49 @@ size_t MessageInputStream::readBytes(int8_t * buffer, size_t length) {
 // {@see MessageInputStream::readUnsignedByte} //////////////////
 /////////////////////////////////////////////////////////////////
 uint8_t MessageInputStream::readUnsignedByte() {
-    return (readByte() ^ 0x80) - 0x80;
+    return readValue<uint8_t>();
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see MessageInputStream::readShort} /////////////////////////
 /////////////////////////////////////////////////////////////////
 int16_t MessageInputStream::readShort() {
-    return int16_t(readUnsignedShort());
+    return int16_t(readValue<uint16_t>());
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see MessageInputStream::readUnsignedShort} /////////////////
 /////////////////////////////////////////////////////////////////
 uint16_t MessageInputStream::readUnsignedShort() {
-    return (isBigEndianness_
-            ? (uint16_t(readUnsignedByte()) << 8) | readUnsignedByte()
-            : readUnsignedByte() | (uint16_t(readUnsignedByte()) << 8));
+    return readValue<uint16_t>();
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see MessageInputStream::readInteger} ///////////////////////
 /////////////////////////////////////////////////////////////////
 int32_t MessageInputStream::readInteger() {
-    return int32_t(readUnsignedInteger());
+    return int32_t(readValue<uint32_t>());
 }
 
 /////////////////////////////////////////////////////////////////
-// {@see MessageInputStream::initialize} ////////////////////////
+// {@see MessageInputStream::readUnsignedInteger} ///////////////
 /////////////////////////////////////////////////////////////////
 uint32_t MessageInputStream::readUnsignedInteger() {
-    return (isBigEndianness_
-            ? (uint32_t(readUnsignedShort()) << 16) | readUnsignedShort()
-            : readUnsignedShort() | (uint32_t(readUnsignedShort()) << 16));
+    return readValue<uint32_t>();
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see MessageInputStream::readLong} //////////////////////////
 /////////////////////////////////////////////////////////////////
 int64_t MessageInputStream::readLong() {
-    return int64_t(readUnsignedLong());
+    return int64_t(readValue<uint64_t>());
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see MessageInputStream::readUnsignedLong} //////////////////
 /////////////////////////////////////////////////////////////////
 uint64_t MessageInputStream::readUnsignedLong() {
-    return (isBigEndianness_
-            ? (uint64_t(readUnsignedInteger()) << 32) | readUnsignedInteger()
-            : readUnsignedInteger() | (uint64_t(readUnsignedInteger()) << 32));
+    return readValue<uint64_t>();
 }
 
 /////////////////////////////////////////////////////////////////
@@ -117,7 +161,7 @@ float MessageInputStream::readFloat() {
         uint32_t index;
         float value;
     } ieee_float;
-    ieee_float.index = readUnsignedInteger();
+    ieee_float.index = readValue<uint32_t>();
     return ieee_float.value;
 }
 
@@ -129,7 +173,7 @@ double MessageInputStream::readDouble() {
         uint64_t index;
         double value;
     } ieee_double;
-    ieee_double.index = readUnsignedLong();
+    ieee_double.index = readValue<uint64_t>();
     return ieee_double.value;
 }
 
@@ -137,12 +181,8 @@ double MessageInputStream::readDouble() {
 // {@see MessageInputStream::readString} ////////////////////////
 /////////////////////////////////////////////////////////////////
 std::string MessageInputStream::readString() {
-    uint8_t length = readUnsignedByte();
-    uint8_t buffer[length];
-    readBytes(
-        reinterpret_cast<int8_t *>(&buffer), length);
-    buffer[length] = 0x00;
-    return std::string((char *)&buffer);
+    boost::string_ref value = readStringView();
+    return std::string(value.data(), value.size());
 }
 
 /////////////////////////////////////////////////////////////////
@@ -150,26 +190,151 @@ std::string MessageInputStream::readString() {
 /////////////////////////////////////////////////////////////////
 std::u16string MessageInputStream::readUnicode() {
     uint32_t length = readUnsignedInteger();
-    uint16_t buffer[length];
-    readBytes(
-        reinterpret_cast<int8_t *>(&buffer), length * 2);
-    buffer[length] = 0x0000;
-    return std::u16string((char16_t *)&buffer);
+    const int8_t * data = readRaw(size_t(length) * 2);
+
+    // Every code unit is copied as it is, embedded NULs included.
+    std::u16string value(length, 0);
+    if (isBigEndianness_ != MESSAGE_HOST_BIG_ENDIAN) {
+        copySwapped(&value[0], data, length, 2);
+    } else if (length > 0) {
+        std::memcpy(&value[0], data, size_t(length) * 2);
+    }
+    return value;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readStringView} ////////////////////
+/////////////////////////////////////////////////////////////////
+boost::string_ref MessageInputStream::readStringView() {
+    uint8_t length = readUnsignedByte();
+    return boost::string_ref(reinterpret_cast<const char *>(readRaw(length)), length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readUnicode} ///////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageInputStream::readUnicode(std::string & value) {
+    uint32_t length = readUnsignedInteger();
+    const int8_t * data = readRaw(size_t(length) * 2);
+
+    value.resize(size_t(length) * MESSAGE_UNICODE_RATIO);
+    value.resize(encodeUtf8(&value[0], data, length, isBigEndianness_ != MESSAGE_HOST_BIG_ENDIAN));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readVarUnsignedInteger} ////////////
+/////////////////////////////////////////////////////////////////
+uint32_t MessageInputStream::readVarUnsignedInteger() {
+    return readVarint<uint32_t>();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readVarInteger} ////////////////////
+/////////////////////////////////////////////////////////////////
+int32_t MessageInputStream::readVarInteger() {
+    return decodeZigzag(readVarint<uint32_t>());
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readVarUnsignedLong} ///////////////
+/////////////////////////////////////////////////////////////////
+uint64_t MessageInputStream::readVarUnsignedLong() {
+    return readVarint<uint64_t>();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readVarLong} ///////////////////////
+/////////////////////////////////////////////////////////////////
+int64_t MessageInputStream::readVarLong() {
+    return decodeZigzag(readVarint<uint64_t>());
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readVarString} /////////////////////
+/////////////////////////////////////////////////////////////////
+std::string MessageInputStream::readVarString() {
+    boost::string_ref value = readVarStringView();
+    return std::string(value.data(), value.size());
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readVarStringView} /////////////////
+/////////////////////////////////////////////////////////////////
+boost::string_ref MessageInputStream::readVarStringView() {
+    uint64_t length = readVarint<uint64_t>();
+    if (uint64_t(limit_ - position_) < length) {
+        throw std::out_of_range("Not enough bytes to read from the stream");
+    }
+    return boost::string_ref(reinterpret_cast<const char *>(readRaw(size_t(length))), size_t(length));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readArray} /////////////////////////
+/////////////////////////////////////////////////////////////////
+template<typename T>
+size_t MessageInputStream::readArray(T * buffer, size_t length) {
+    if (size_t(limit_ - position_) / sizeof(T) < length) {
+        throw std::out_of_range("Not enough bytes to read from the stream");
+    }
+    if (isBigEndianness_ != MESSAGE_HOST_BIG_ENDIAN) {
+        copySwapped(buffer, position_, length, sizeof(T));
+    } else {
+        std::memcpy(buffer, position_, length * sizeof(T));
+    }
+    position_ += length * sizeof(T);
+    return length;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readShortArray} ////////////////////
+/////////////////////////////////////////////////////////////////
+size_t MessageInputStream::readShortArray(int16_t * buffer, size_t length) {
+    return readArray(buffer, length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readIntegerArray} //////////////////
+/////////////////////////////////////////////////////////////////
+size_t MessageInputStream::readIntegerArray(int32_t * buffer, size_t length) {
+    return readArray(buffer, length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readLongArray} /////////////////////
+/////////////////////////////////////////////////////////////////
+size_t MessageInputStream::readLongArray(int64_t * buffer, size_t length) {
+    return readArray(buffer, length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readFloatArray} ////////////////////
+/////////////////////////////////////////////////////////////////
+size_t MessageInputStream::readFloatArray(float * buffer, size_t length) {
+    return readArray(buffer, length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageInputStream::readDoubleArray} ///////////////////
+/////////////////////////////////////////////////////////////////
+size_t MessageInputStream::readDoubleArray(double * buffer, size_t length) {
+    return readArray(buffer, length);
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see MessageInputStream::getLength} /////////////////////////
 /////////////////////////////////////////////////////////////////
 size_t MessageInputStream::getLength() {
-    return buffer_.size();
+    return limit_ - position_;
 }
 
 /////////////////////////////////////////////////////////////////
 // {@see MessageInputStream::skipBytes} /////////////////////////
 /////////////////////////////////////////////////////////////////
 void MessageInputStream::skipBytes(size_t length) {
-    for (size_t i = 0; i < length; i++)
-        buffer_.pop_front();
+    if (size_t(limit_ - position_) < length) {
+        length = limit_ - position_;
+    }
+    position_ += length;
 }
 
 /////////////////////////////////////////////////////////////////
@@ -183,5 +348,6 @@ void MessageInputStream::setEndianness(bool isBigEndianness) {
 // {@see MessageInputStream::getBuffer} /////////////////////////
 /////////////////////////////////////////////////////////////////
 std::deque<int8_t> & MessageInputStream::getBuffer() {
-    return buffer_;
+    copy_.assign(position_, limit_);
+    return copy_;
 }
\ No newline at end of file
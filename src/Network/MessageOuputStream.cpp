@@ -15,5 +15,334 @@
  */
 
 #include <Network/MessageOutputStream.hpp>
+#include <Network/MessageBufferPool.hpp>
+#include <Network/MessageEndian.hpp>
+#include <Network/MessageVarint.hpp>
+#include <cstring>
+#include <stdexcept>
 
-using namespace Ghrum;
\ No newline at end of file
+using namespace Ghrum;
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::MessageOutputStream} //////////////
+/////////////////////////////////////////////////////////////////
+MessageOutputStream::MessageOutputStream()
+    : isBigEndianness_(false), isPooled_(true), buffer_(MessageBufferPool::getInstance().acquire()) {
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::MessageOutputStream} //////////////
+/////////////////////////////////////////////////////////////////
+MessageOutputStream::MessageOutputStream(MessageBuffer & buffer)
+    : isBigEndianness_(false), isPooled_(false), buffer_(&buffer) {
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::~MessageOutputStream} /////////////
+/////////////////////////////////////////////////////////////////
+MessageOutputStream::~MessageOutputStream() {
+    if (isPooled_) {
+        MessageBufferPool::getInstance().release(buffer_);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeValue} ///////////////////////
+/////////////////////////////////////////////////////////////////
+template<typename T>
+void MessageOutputStream::writeValue(T value) {
+    if (isBigEndianness_ != MESSAGE_HOST_BIG_ENDIAN) {
+        value = swapBytes(value);
+    }
+
+    // The bytes aren't aligned, memcpy of a fixed size compiles
+    // into a single unaligned store.
+    std::memcpy(buffer_->prepare(sizeof(T)), &value, sizeof(T));
+    buffer_->commit(sizeof(T));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeVarint} //////////////////////
+/////////////////////////////////////////////////////////////////
+template<typename T>
+void MessageOutputStream::writeVarint(T value) {
+    buffer_->commit(encodeVarint(buffer_->prepare(MESSAGE_VARINT_LENGTH), value));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::patchValue} ///////////////////////
+/////////////////////////////////////////////////////////////////
+template<typename T>
+void MessageOutputStream::patchValue(size_t position, T value) {
+    if (position + sizeof(T) > buffer_->getLength()) {
+        throw std::out_of_range("Patching past the end of the stream");
+    }
+    if (isBigEndianness_ != MESSAGE_HOST_BIG_ENDIAN) {
+        value = swapBytes(value);
+    }
+    std::memcpy(buffer_->getData() + position, &value, sizeof(T));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeBoolean} /////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeBoolean(bool value) {
+    writeValue<uint8_t>(value ? 1 : 0);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeByte} ////////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeByte(int8_t value) {
+    writeValue<uint8_t>(uint8_t(value));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeBytes} ///////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeBytes(const int8_t * buffer, size_t length) {
+    buffer_->write(buffer, length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeUnsignedByte} ////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeUnsignedByte(uint8_t value) {
+    writeValue<uint8_t>(value);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeShort} ///////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeShort(int16_t value) {
+    writeValue<uint16_t>(uint16_t(value));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeUnsignedShort} ///////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeUnsignedShort(uint16_t value) {
+    writeValue<uint16_t>(value);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeInteger} /////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeInteger(int32_t value) {
+    writeValue<uint32_t>(uint32_t(value));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeUnsignedInteger} /////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeUnsignedInteger(uint32_t value) {
+    writeValue<uint32_t>(value);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeLong} ////////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeLong(int64_t value) {
+    writeValue<uint64_t>(uint64_t(value));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeUnsignedLong} ////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeUnsignedLong(uint64_t value) {
+    writeValue<uint64_t>(value);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeFloat} ///////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeFloat(float value) {
+    union {
+        uint32_t index;
+        float value;
+    } ieee_float;
+    ieee_float.value = value;
+    writeValue<uint32_t>(ieee_float.index);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeDouble} //////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeDouble(double value) {
+    union {
+        uint64_t index;
+        double value;
+    } ieee_double;
+    ieee_double.value = value;
+    writeValue<uint64_t>(ieee_double.index);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeString} //////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeString(const std::string & value) {
+    if (value.size() > UINT8_MAX) {
+        throw std::length_error("String too long for the stream");
+    }
+    writeValue<uint8_t>(uint8_t(value.size()));
+    buffer_->write(reinterpret_cast<const int8_t *>(value.data()), value.size());
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeUnicode} /////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeUnicode(const std::u16string & value) {
+    writeValue<uint32_t>(uint32_t(value.size()));
+    writeArray(reinterpret_cast<const uint16_t *>(value.data()), value.size());
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeVarUnsignedInteger} //////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeVarUnsignedInteger(uint32_t value) {
+    writeVarint(value);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeVarInteger} //////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeVarInteger(int32_t value) {
+    writeVarint(encodeZigzag(value));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeVarUnsignedLong} /////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeVarUnsignedLong(uint64_t value) {
+    writeVarint(value);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeVarLong} /////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeVarLong(int64_t value) {
+    writeVarint(encodeZigzag(value));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeVarString} ///////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeVarString(const std::string & value) {
+    writeVarint(uint64_t(value.size()));
+    buffer_->write(reinterpret_cast<const int8_t *>(value.data()), value.size());
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeArray} ///////////////////////
+/////////////////////////////////////////////////////////////////
+template<typename T>
+void MessageOutputStream::writeArray(const T * buffer, size_t length) {
+    int8_t * data = buffer_->prepare(length * sizeof(T));
+    if (isBigEndianness_ != MESSAGE_HOST_BIG_ENDIAN) {
+        copySwapped(data, buffer, length, sizeof(T));
+    } else {
+        std::memcpy(data, buffer, length * sizeof(T));
+    }
+    buffer_->commit(length * sizeof(T));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeShortArray} //////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeShortArray(const int16_t * buffer, size_t length) {
+    writeArray(buffer, length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeIntegerArray} ////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeIntegerArray(const int32_t * buffer, size_t length) {
+    writeArray(buffer, length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeLongArray} ///////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeLongArray(const int64_t * buffer, size_t length) {
+    writeArray(buffer, length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeFloatArray} //////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeFloatArray(const float * buffer, size_t length) {
+    writeArray(buffer, length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::writeDoubleArray} /////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::writeDoubleArray(const double * buffer, size_t length) {
+    writeArray(buffer, length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::getLength} ////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t MessageOutputStream::getLength() {
+    return buffer_->getLength();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::setEndianness} ////////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::setEndianness(bool isBigEndianness) {
+    isBigEndianness_ = isBigEndianness;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::reserve} //////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t MessageOutputStream::reserve(size_t length) {
+    size_t position = buffer_->getLength();
+    std::memset(buffer_->prepare(length), 0, length);
+    buffer_->commit(length);
+    return position;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::patchUnsignedByte} ////////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::patchUnsignedByte(size_t position, uint8_t value) {
+    patchValue<uint8_t>(position, value);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::patchUnsignedShort} ///////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::patchUnsignedShort(size_t position, uint16_t value) {
+    patchValue<uint16_t>(position, value);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::patchUnsignedInteger} /////////////
+/////////////////////////////////////////////////////////////////
+void MessageOutputStream::patchUnsignedInteger(size_t position, uint32_t value) {
+    patchValue<uint32_t>(position, value);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::getMessageBuffer} /////////////////
+/////////////////////////////////////////////////////////////////
+MessageBuffer & MessageOutputStream::getMessageBuffer() {
+    return *buffer_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see MessageOutputStream::share} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+std::shared_ptr<const MessageBuffer> MessageOutputStream::share() {
+    MessageBufferPool & pool = MessageBufferPool::getInstance();
+    MessageBuffer * buffer = pool.acquire();
+    if (isPooled_) {
+        std::swap(buffer, buffer_);
+    } else {
+        buffer->write(buffer_->getData(), buffer_->getLength());
+    }
+    return pool.share(buffer);
+}
\ No newline at end of file
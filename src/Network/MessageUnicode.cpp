@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Network/MessageUnicode.hpp>
+#include <Network/MessageEndian.hpp>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MESSAGE_UNICODE_X86
+#include <immintrin.h>
+#endif
+
+using namespace Ghrum;
+
+/**
+ * A type definition of a kernel that transcodes UTF-16 into UTF-8.
+ */
+typedef size_t (*UnicodeKernel)(char *, const int8_t *, size_t, bool);
+
+/////////////////////////////////////////////////////////////////
+// {@see loadUnit} //////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+static inline uint16_t loadUnit(const int8_t * source, size_t index, bool isSwapped) {
+    uint16_t unit;
+    std::memcpy(&unit, source + index * 2, sizeof(unit));
+    return (isSwapped ? swapBytes(unit) : unit);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see encodeRange} ///////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+static size_t encodeRange(char * destination, const int8_t * source, size_t & position, size_t end, size_t count,
+                          bool isSwapped) {
+    // The position is kept in a local, a store through a char pointer
+    // could alias it and force a reload on every byte.
+    size_t index = position, length = 0;
+
+    // The low surrogate of a pair may be past the end of the range, so
+    // the range can grow by one code unit.
+    while (index < end) {
+        uint32_t code = loadUnit(source, index++, isSwapped);
+        if (code < 0x80) {
+            destination[length++] = char(code);
+            continue;
+        }
+        if (code < 0x800) {
+            destination[length++] = char(0xC0 | (code >> 6));
+            destination[length++] = char(0x80 | (code & 0x3F));
+            continue;
+        }
+        if (code >= 0xD800 && code <= 0xDFFF) {
+            uint32_t next = (index < count ? loadUnit(source, index, isSwapped) : 0);
+            if (code <= 0xDBFF && next >= 0xDC00 && next <= 0xDFFF) {
+                code = 0x10000 + ((code - 0xD800) << 10) + (next - 0xDC00);
+                index++;
+                destination[length++] = char(0xF0 | (code >> 18));
+                destination[length++] = char(0x80 | ((code >> 12) & 0x3F));
+                destination[length++] = char(0x80 | ((code >> 6) & 0x3F));
+                destination[length++] = char(0x80 | (code & 0x3F));
+                continue;
+            }
+            code = 0xFFFD;
+        }
+        destination[length++] = char(0xE0 | (code >> 12));
+        destination[length++] = char(0x80 | ((code >> 6) & 0x3F));
+        destination[length++] = char(0x80 | (code & 0x3F));
+    }
+    position = index;
+    return length;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see encodeScalar} //////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+static size_t encodeScalar(char * destination, const int8_t * source, size_t count, bool isSwapped) {
+    size_t index = 0;
+    return encodeRange(destination, source, index, count, count, isSwapped);
+}
+
+#ifdef MESSAGE_UNICODE_X86
+
+/////////////////////////////////////////////////////////////////
+// {@see encodeSSE2} ////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+__attribute__((target("sse2")))
+static size_t encodeSSE2(char * destination, const int8_t * source, size_t count, bool isSwapped) {
+    const __m128i mask = _mm_set1_epi16(short(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    size_t index = 0, length = 0;
+
+    // Sixteen ASCII characters are narrowed with a single pack, any other
+    // block is transcoded one code unit at a time.
+    while (index + 16 <= count) {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + index * 2));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + index * 2 + 16));
+        if (isSwapped) {
+            first = _mm_or_si128(_mm_slli_epi16(first, 8), _mm_srli_epi16(first, 8));
+            second = _mm_or_si128(_mm_slli_epi16(second, 8), _mm_srli_epi16(second, 8));
+        }
+        __m128i high = _mm_and_si128(_mm_or_si128(first, second), mask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) == 0xFFFF) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + length), _mm_packus_epi16(first, second));
+            index += 16;
+            length += 16;
+        } else {
+            length += encodeRange(destination + length, source, index, index + 16, count, isSwapped);
+        }
+    }
+
+    // Eight more characters are narrowed the same way before going
+    // one code unit at a time.
+    if (index + 8 <= count) {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + index * 2));
+        if (isSwapped) {
+            first = _mm_or_si128(_mm_slli_epi16(first, 8), _mm_srli_epi16(first, 8));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(first, mask), zero)) == 0xFFFF) {
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(destination + length), _mm_packus_epi16(first, first));
+            index += 8;
+            length += 8;
+        }
+    }
+    return length + encodeRange(destination + length, source, index, count, count, isSwapped);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see encodeAVX2} ////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+__attribute__((target("avx2")))
+static size_t encodeAVX2(char * destination, const int8_t * source, size_t count, bool isSwapped) {
+    const __m256i mask = _mm256_set1_epi16(short(0xFF80));
+    size_t index = 0, length = 0;
+
+    while (index + 32 <= count) {
+        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + index * 2));
+        __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + index * 2 + 32));
+        if (isSwapped) {
+            first = _mm256_or_si256(_mm256_slli_epi16(first, 8), _mm256_srli_epi16(first, 8));
+            second = _mm256_or_si256(_mm256_slli_epi16(second, 8), _mm256_srli_epi16(second, 8));
+        }
+        if (_mm256_testz_si256(_mm256_or_si256(first, second), mask)) {
+            // The pack works within each 128 bit lane, so the quarters
+            // are put back in order afterwards.
+            __m256i packed = _mm256_packus_epi16(first, second);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + length),
+                                _mm256_permute4x64_epi64(packed, 0xD8));
+            index += 32;
+            length += 32;
+        } else {
+            length += encodeRange(destination + length, source, index, index + 32, count, isSwapped);
+        }
+    }
+
+    // The rest is handled by the SSE2 kernel, which may be inlined since
+    // its target is a subset of this one.
+    return length + encodeSSE2(destination + length, source + index * 2, count - index, isSwapped);
+}
+
+#endif // MESSAGE_UNICODE_X86
+
+/////////////////////////////////////////////////////////////////
+// {@see getKernel} /////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+static UnicodeKernel getKernel() {
+#ifdef MESSAGE_UNICODE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &encodeAVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return &encodeSSE2;
+    }
+#endif
+    return &encodeScalar;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see encodeUtf8} ////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t Ghrum::encodeUtf8(char * destination, const void * source, size_t count, bool isSwapped) {
+    static const UnicodeKernel kernel = getKernel();
+    return kernel(destination, static_cast<const int8_t *>(source), count, isSwapped);
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Network/Reactor.hpp>
+#include <Utilities/Delegate.hpp>
+
+using namespace Ghrum;
+
+/**
+ * Reactor run by the current thread or nullptr.
+ */
+static thread_local Reactor * g_CurrentReactor = nullptr;
+
+/////////////////////////////////////////////////////////////////
+// {@see Reactor::Reactor} //////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+Reactor::Reactor(size_t id)
+    : id_(id), service_(1), work_(new boost::asio::io_service::work(service_)) {
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Reactor::~Reactor} /////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+Reactor::~Reactor() {
+    stop();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Reactor::start} ////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Reactor::start() {
+    thread_ = std::unique_ptr<boost::thread>(
+                  new boost::thread(Delegate<void()>(this, &Reactor::run)));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Reactor::stop} /////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Reactor::stop() {
+    work_.reset();
+    service_.stop();
+    if (thread_ && thread_->joinable()) {
+        thread_->join();
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Reactor::getId} ////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t Reactor::getId() {
+    return id_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Reactor::isCurrentThread} //////////////////////////////
+/////////////////////////////////////////////////////////////////
+bool Reactor::isCurrentThread() {
+    return g_CurrentReactor == this;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Reactor::getService} ///////////////////////////////////
+/////////////////////////////////////////////////////////////////
+boost::asio::io_service & Reactor::getService() {
+    return service_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Reactor::run} //////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Reactor::run() {
+    g_CurrentReactor = this;
+
+    // A handler that throws must not take the reactor down, every
+    // session of the reactor would be lost.
+    while (!service_.stopped()) {
+        try {
+            service_.run();
+        } catch (std::exception & ex) {
+            BOOST_LOG_TRIVIAL(error)
+                    << "[*] <Reactor " << id_ << "> " << ex.what();
+        }
+    }
+}
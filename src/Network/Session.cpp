@@ -15,5 +15,621 @@
  */
 
 #include <Network/Session.hpp>
+#include <Network/SessionManager.hpp>
+#include <Network/MessageBufferPool.hpp>
+#include <Network/MessageVarint.hpp>
 
-using namespace Ghrum;
\ No newline at end of file
+using namespace Ghrum;
+
+/////////////////////////////////////////////////////////////////
+// {@see getEncodeBuffer} ///////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+static MessageBuffer & getEncodeBuffer() {
+    static thread_local MessageBuffer buffer;
+    return buffer;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see getDecodeBuffer} ///////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+static MessageBuffer & getDecodeBuffer() {
+    static thread_local MessageBuffer buffer;
+    return buffer;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::Session} //////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+Session::Session(SessionManager & manager, Reactor & reactor, size_t id)
+    : manager_(manager), reactor_(reactor), id_(id), socket_(reactor.getService()), slow_(reactor.getService()),
+      connected_(false),
+      congested_(false), depth_(0), writing_(false), queued_(false), flushing_(false), isReplay_(false),
+      messages_(0),
+      sendingLength_(0), threshold_(MESSAGE_COMPRESSION_THRESHOLD), limit_(manager.getSendLimit()),
+      compression_(MessageCompression::None), parser_(manager.getFrameParser()) {
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::getId} ////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t Session::getId() {
+    return id_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::getAddress} ///////////////////////////////////
+/////////////////////////////////////////////////////////////////
+std::string Session::getAddress() {
+    boost::system::error_code error;
+    boost::asio::ip::tcp::endpoint endpoint = socket_.remote_endpoint(error);
+    return (error ? std::string() : endpoint.address().to_string());
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::isConnected} //////////////////////////////////
+/////////////////////////////////////////////////////////////////
+bool Session::isConnected() {
+    return connected_.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::isCongested} //////////////////////////////////
+/////////////////////////////////////////////////////////////////
+bool Session::isCongested() {
+    return congested_.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::getQueueDepth} ////////////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t Session::getQueueDepth() {
+    return depth_.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::send} /////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::send(const int8_t * data, size_t length, bool isDroppable) {
+    if (reactor_.isCurrentThread()) {
+        write(data, length, isDroppable);
+        return;
+    }
+
+    // A droppable message is discarded before it is even copied.
+    if (isDroppable && isCongested()) {
+        manager_.onDrop();
+        return;
+    }
+
+    // The bytes are copied into a pooled buffer that is given back
+    // once the reactor has appended them.
+    MessageBuffer * buffer = MessageBufferPool::getInstance().acquire();
+    buffer->write(data, length);
+
+    std::shared_ptr<Session> self = shared_from_this();
+    reactor_.getService().post([self, buffer, isDroppable]() {
+        self->write(buffer->getData(), buffer->getLength(), isDroppable);
+        MessageBufferPool::getInstance().release(buffer);
+    });
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::send} /////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::send(MessageOutputStream & stream, bool isDroppable) {
+    MessageBuffer & buffer = stream.getMessageBuffer();
+    send(buffer.getData(), buffer.getLength(), isDroppable);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::send} /////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::send(std::shared_ptr<const MessageBuffer> buffer, bool isDroppable) {
+    if (reactor_.isCurrentThread()) {
+        write(buffer, isDroppable);
+        return;
+    }
+    if (isDroppable && isCongested()) {
+        manager_.onDrop();
+        return;
+    }
+    std::shared_ptr<Session> self = shared_from_this();
+    reactor_.getService().post([self, buffer, isDroppable]() {
+        self->write(buffer, isDroppable);
+    });
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::close} ////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::close() {
+    std::shared_ptr<Session> self = shared_from_this();
+    reactor_.getService().dispatch([self]() {
+        self->doClose();
+    });
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::setCompression} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::setCompression(MessageCompression compression, size_t threshold) {
+    if (compression != MessageCompression::None && parser_.getPrefix() == MessageFramePrefix::None) {
+        throw std::invalid_argument("Compression needs a session with frames");
+    }
+    if (!MessageCompressor::isSupported(compression)) {
+        throw std::invalid_argument("Compression not supported");
+    }
+    std::shared_ptr<Session> self = shared_from_this();
+    reactor_.getService().dispatch([self, compression, threshold]() {
+        self->compression_ = compression;
+        self->threshold_ = threshold;
+    });
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::getReactor} ///////////////////////////////////
+/////////////////////////////////////////////////////////////////
+Reactor & Session::getReactor() {
+    return reactor_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::getSocket} ////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+boost::asio::ip::tcp::socket & Session::getSocket() {
+    return socket_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::start} ////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::start() {
+    boost::system::error_code error;
+    socket_.set_option(boost::asio::ip::tcp::no_delay(true), error);
+    connected_ = true;
+    doRead();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::startReplay} //////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::startReplay() {
+    isReplay_ = true;
+    connected_ = true;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::receive} //////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::receive(const int8_t * data, size_t length) {
+    if (!connected_) {
+        return;
+    }
+    try {
+        input_.write(data, length);
+    } catch (std::bad_alloc &) {
+        BOOST_LOG_TRIVIAL(error)
+                << "[*] <Session " << id_ << "> Out of buffer memory while reading.";
+        doClose();
+        return;
+    }
+    doProcess();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::write} ////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::write(const int8_t * data, size_t length, bool isDroppable) {
+    // The frames are encoded before the bytes are accounted, unless the
+    // session would discard them anyway. The buffer of the thread is
+    // taken while the bytes are appended, as a delegate called meanwhile
+    // may encode for another session.
+    if (compression_ != MessageCompression::None && connected_ && !(isDroppable && isCongested())) {
+        MessageBuffer & scratch = getEncodeBuffer();
+        MessageBuffer encoded(std::move(scratch));
+        encoded.clear();
+
+        // The bytes may be sent from the handler of another session, the
+        // failure belongs to this one and must not reach the handler.
+        try {
+            doEncode(data, length, encoded);
+        } catch (std::exception & ex) {
+            BOOST_LOG_TRIVIAL(error)
+                    << "[*] <Session " << id_ << "> " << ex.what();
+            scratch = std::move(encoded);
+            doClose();
+            return;
+        }
+        doAppend(encoded.getData(), encoded.getLength(), isDroppable);
+        scratch = std::move(encoded);
+    } else {
+        doAppend(data, length, isDroppable);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::doAppend} /////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::doAppend(const int8_t * data, size_t length, bool isDroppable) {
+    if (!doReserve(length, isDroppable)) {
+        return;
+    }
+
+    // A session whose bytes can't be held anymore is dropped.
+    try {
+        pending_.write(data, length);
+    } catch (std::bad_alloc &) {
+        BOOST_LOG_TRIVIAL(error)
+                << "[*] <Session " << id_ << "> Out of buffer memory while sending.";
+        doClose();
+        return;
+    }
+
+    // Consecutive messages share a single segment of the own buffer,
+    // which is only cleared after a write so offsets stay valid.
+    if (pendingSegment_.empty() || pendingSegment_.back().buffer) {
+        Segment segment = { nullptr, pending_.getLength() - length, 0 };
+        pendingSegment_.push_back(segment);
+    }
+    pendingSegment_.back().length += length;
+    doQueue();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::write} ////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::write(std::shared_ptr<const MessageBuffer> buffer, bool isDroppable) {
+    // A shared buffer holds the frames as sent, a compressed session
+    // writes its own copy of them.
+    if (compression_ != MessageCompression::None) {
+        write(buffer->getData(), buffer->getLength(), isDroppable);
+        return;
+    }
+    if (!doReserve(buffer->getLength(), isDroppable)) {
+        return;
+    }
+    Segment segment = { buffer, 0, buffer->getLength() };
+    pendingSegment_.push_back(segment);
+    doQueue();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::doReserve} ////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+bool Session::doReserve(size_t length, bool isDroppable) {
+    if (!connected_ || length == 0 || doCheckSlow()) {
+        return false;
+    }
+
+    // A droppable message is superseded by a later one, so it is the
+    // first thing given up once the session falls behind.
+    if (isDroppable && congested_.load(std::memory_order_relaxed)) {
+        manager_.onDrop();
+        return false;
+    }
+
+    // The depth is only changed by the thread of the reactor, other
+    // threads only read it.
+    size_t depth = depth_.load(std::memory_order_relaxed) + length;
+    if (depth > limit_.limit) {
+        BOOST_LOG_TRIVIAL(warning)
+                << "[*] <Session " << id_ << "> Too many bytes waiting to be sent, disconnecting.";
+        manager_.onSlow();
+        doClose();
+        return false;
+    }
+    depth_.store(depth, std::memory_order_relaxed);
+
+    if (depth > limit_.highWatermark && !congested_.load(std::memory_order_relaxed)) {
+        congested_ = true;
+        congestedAt_ = std::chrono::steady_clock::now();
+        manager_.onCongestion(*this, true);
+
+        // A session that is only sent droppable messages never reaches
+        // the check again, so the timeout is checked on its own too.
+        doWaitSlow();
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::doCheckSlow} //////////////////////////////////
+/////////////////////////////////////////////////////////////////
+bool Session::doCheckSlow() {
+    if (!congested_.load(std::memory_order_relaxed)
+            || std::chrono::steady_clock::now() - congestedAt_ < std::chrono::milliseconds(limit_.timeout)) {
+        return false;
+    }
+    BOOST_LOG_TRIVIAL(warning)
+            << "[*] <Session " << id_ << "> Congested for too long, disconnecting.";
+    manager_.onSlow();
+    doClose();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::doWaitSlow} ///////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::doWaitSlow() {
+    // The timer runs on the clock of the check, a timer that fires
+    // before the timeout is due waits again for what is left.
+    std::shared_ptr<Session> self = shared_from_this();
+    slow_.expires_at(congestedAt_ + std::chrono::milliseconds(limit_.timeout));
+    slow_.async_wait([self](const boost::system::error_code & error) {
+        if (!error && self->connected_ && self->congested_.load(std::memory_order_relaxed)
+                && !self->doCheckSlow())
+            self->doWaitSlow();
+    });
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::doQueue} //////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::doQueue() {
+    messages_++;
+
+    // The first message since the last flush queues the session to be
+    // flushed at the end of the tick.
+    if (!queued_) {
+        queued_ = true;
+        manager_.onQueue(*this);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::flush} ////////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::flush() {
+    queued_ = false;
+    if (!connected_ || pendingSegment_.empty() || doCheckSlow()) {
+        return;
+    }
+
+    // A write still in progress flushes the pending bytes as soon
+    // as it completes.
+    if (writing_) {
+        flushing_ = true;
+    } else {
+        doWrite();
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::doRead} ///////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::doRead() {
+    int8_t * buffer;
+    try {
+        buffer = input_.prepare(SESSION_READ_LENGTH);
+    } catch (std::bad_alloc &) {
+        BOOST_LOG_TRIVIAL(error)
+                << "[*] <Session " << id_ << "> Out of buffer memory while reading.";
+        doClose();
+        return;
+    }
+
+    std::shared_ptr<Session> self = shared_from_this();
+    socket_.async_read_some(
+        boost::asio::buffer(buffer, SESSION_READ_LENGTH),
+    [self](const boost::system::error_code & error, size_t length) {
+        self->onRead(error, length);
+    });
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::onRead} ///////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::onRead(const boost::system::error_code & error, size_t length) {
+    if (error) {
+        doClose();
+        return;
+    }
+    input_.commit(length);
+    manager_.onRead(*this, input_.getData() + input_.getLength() - length, length);
+
+    doProcess();
+    if (connected_) {
+        doRead();
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::doProcess} ////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::doProcess() {
+    try {
+        doReceive();
+    } catch (std::exception & ex) {
+        BOOST_LOG_TRIVIAL(error)
+                << "[*] <Session " << id_ << "> " << ex.what();
+        doClose();
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::doReceive} ////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::doReceive() {
+    // Without frames, the handler consumes every complete message and
+    // leaves the rest in the buffer.
+    if (parser_.getPrefix() == MessageFramePrefix::None) {
+        {
+            MessageInputStream stream(input_);
+            stream.setEndianness(parser_.isBigEndianness());
+            manager_.onReceive(*this, stream);
+        }
+
+        // Nothing bounds an incomplete message but the limit of the
+        // frames, past it the peer is only filling the buffer.
+        if (input_.getLength() > parser_.getLimit()) {
+            throw std::length_error("Message longer than the limit");
+        }
+        return;
+    }
+
+    // Every frame is read in place, bounded to its own bytes.
+    size_t offset, size;
+    while (connected_ && parser_.next(input_.getData(), input_.getLength(), offset, size)) {
+        doDispatch(input_.getData() + offset, size);
+        input_.consume(offset + size);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::doDispatch} ///////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::doDispatch(const int8_t * data, size_t size) {
+    if (compression_ != MessageCompression::None) {
+        uint32_t length;
+        size_t offset = decodeVarint(data, size, length);
+        if (offset == 0) {
+            throw std::length_error("Malformed compressed frame");
+        }
+        data += offset;
+        size -= offset;
+
+        // The body is decompressed into a buffer of the reactor, which
+        // keeps its capacity for the next frame.
+        if (length > 0) {
+            if (length > parser_.getLimit()) {
+                throw std::length_error("Frame longer than the limit");
+            }
+            MessageBuffer & buffer = getDecodeBuffer();
+            buffer.clear();
+            MessageCompressor::getInstance().decompress(compression_, data, size, buffer.prepare(length), length);
+            buffer.commit(length);
+            data = buffer.getData();
+            size = length;
+        }
+    }
+
+    MessageInputStream stream(data, size);
+    stream.setEndianness(parser_.isBigEndianness());
+    manager_.onReceive(*this, stream);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::doEncode} /////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::doEncode(const int8_t * data, size_t length, MessageBuffer & output) {
+    const size_t header = MESSAGE_FRAME_PREFIX_LENGTH + MESSAGE_VARINT_LENGTH;
+    MessageCompressor & compressor = MessageCompressor::getInstance();
+
+    size_t offset, size;
+    while (length > 0) {
+        if (!parser_.next(data, length, offset, size)) {
+            throw std::length_error("Partial frame sent to a compressed session");
+        }
+        const int8_t * body = data + offset;
+        data += offset + size;
+        length -= offset + size;
+
+        // The body is compressed past the room of the largest header,
+        // then moved right after the real one. A body that doesn't get
+        // any smaller is sent as is.
+        if (size >= threshold_) {
+            int8_t * room = output.prepare(header + compressor.getBound(compression_, size));
+            size_t packed = compressor.compress(compression_, body, size, room + header);
+            int8_t inner[MESSAGE_VARINT_LENGTH];
+            size_t innerLength = encodeVarint(inner, uint32_t(size));
+            if (packed < size && innerLength + packed <= parser_.getLimit()) {
+                size_t prefixLength = parser_.encode(room, innerLength + packed);
+                std::memmove(room + prefixLength + innerLength, room + header, packed);
+                std::memcpy(room + prefixLength, inner, innerLength);
+                output.commit(prefixLength + innerLength + packed);
+                continue;
+            }
+        }
+        // The body is sent as is after a single byte, which may take a
+        // frame already at the limit over it.
+        if (size + 1 > parser_.getLimit()) {
+            throw std::length_error("Frame longer than the limit once compressed");
+        }
+        int8_t * room = output.prepare(header + size);
+        size_t prefixLength = parser_.encode(room, size + 1);
+        room[prefixLength] = 0;
+        std::memcpy(room + prefixLength + 1, body, size);
+        output.commit(prefixLength + 1 + size);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::doWrite} //////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::doWrite() {
+    // Bytes sent while a write is in progress are appended to the
+    // pending buffer, which is swapped in once the write completes.
+    std::swap(pending_, sending_);
+    std::swap(pendingSegment_, sendingSegment_);
+    writing_ = true;
+    manager_.onWrite(*this, messages_);
+    messages_ = 0;
+
+    // Every segment is gathered into a single write, shared buffers
+    // are written in place.
+    sequence_.clear();
+    for (const Segment & segment : sendingSegment_) {
+        const int8_t * data = (segment.buffer ? segment.buffer->getData() : sending_.getData());
+        sequence_.push_back(boost::asio::const_buffer(data + segment.offset, segment.length));
+        sendingLength_ += segment.length;
+    }
+
+    // A replayed session has no peer, its bytes are discarded as if
+    // they were written at once.
+    std::shared_ptr<Session> self = shared_from_this();
+    if (isReplay_) {
+        size_t length = sendingLength_;
+        reactor_.getService().post([self, length]() {
+            self->onWrite(boost::system::error_code(), length);
+        });
+        return;
+    }
+    boost::asio::async_write(socket_, sequence_,
+    [self](const boost::system::error_code & error, size_t length) {
+        self->onWrite(error, length);
+    });
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::onWrite} //////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::onWrite(const boost::system::error_code & error, size_t) {
+    writing_ = false;
+    sending_.clear();
+    sendingSegment_.clear();
+    if (error) {
+        doClose();
+        return;
+    }
+
+    // Producers are released once the session has caught up enough,
+    // not as soon as it is under the high watermark, so they don't
+    // flip on every write.
+    size_t depth = depth_.load(std::memory_order_relaxed) - sendingLength_;
+    depth_.store(depth, std::memory_order_relaxed);
+    sendingLength_ = 0;
+    if (depth <= limit_.lowWatermark && congested_.load(std::memory_order_relaxed)) {
+        congested_ = false;
+        slow_.cancel();
+        manager_.onCongestion(*this, false);
+    }
+
+    if (flushing_) {
+        flushing_ = false;
+        doWrite();
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see Session::doClose} //////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Session::doClose() {
+    if (!connected_.exchange(false)) {
+        return;
+    }
+    boost::system::error_code error;
+    slow_.cancel(error);
+    socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+    socket_.close(error);
+    manager_.onClose(*this);
+}
\ No newline at end of file
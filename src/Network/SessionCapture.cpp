@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Network/SessionCapture.hpp>
+#include <Network/MessageOutputStream.hpp>
+#include <Utilities/Delegate.hpp>
+#include <stdexcept>
+
+using namespace Ghrum;
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionCapture::SessionCapture} ////////////////////////
+/////////////////////////////////////////////////////////////////
+SessionCapture::SessionCapture(const std::string & path, const MessageFrameParser & parser)
+    : file_(std::fopen(path.c_str(), "wb")), buffer_(SESSION_CAPTURE_BUFFER),
+      pending_(SESSION_CAPTURE_BUFFER), isReady_(false), isRunning_(true),
+      last_(std::chrono::steady_clock::now()) {
+    if (file_ == nullptr) {
+        throw std::runtime_error("Failed to create the capture " + path);
+    }
+
+    // The header is always little endian, whatever the frames are.
+    MessageOutputStream stream(buffer_);
+    stream.setEndianness(false);
+    stream.writeUnsignedInteger(SESSION_CAPTURE_MAGIC);
+    stream.writeUnsignedByte(SESSION_CAPTURE_VERSION);
+    stream.writeUnsignedByte(uint8_t(parser.getPrefix()));
+    stream.writeBoolean(parser.isBigEndianness());
+    stream.writeVarUnsignedLong(parser.getLimit());
+
+    thread_ = std::unique_ptr<boost::thread>(
+                  new boost::thread(Delegate<void()>(this, &SessionCapture::run)));
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionCapture::~SessionCapture} ///////////////////////
+/////////////////////////////////////////////////////////////////
+SessionCapture::~SessionCapture() {
+    {
+        // =================== Lock ===================
+        boost::mutex::scoped_lock lock(mutex_);
+        // =================== Lock ===================
+        isRunning_ = false;
+    }
+    condition_.notify_one();
+    thread_->join();
+
+    doWrite(buffer_);
+    std::fclose(file_);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionCapture::write} /////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionCapture::write(SessionRecord record, size_t session, const int8_t * data, size_t length) {
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+
+    // The time is taken with the lock held, so the records are in the
+    // order of their time whatever thread wrote them.
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_).count();
+    last_ = now;
+
+    MessageOutputStream stream(buffer_);
+    stream.writeUnsignedByte(uint8_t(record));
+    stream.writeVarUnsignedLong(elapsed);
+    stream.writeVarUnsignedLong(session);
+    if (record == SessionRecord::Receive) {
+        stream.writeVarUnsignedLong(length);
+        stream.writeBytes(data, length);
+    }
+
+    // A writer still busy with the previous buffer takes this one once
+    // done, meanwhile it only grows.
+    if (buffer_.getLength() >= SESSION_CAPTURE_BUFFER && !isReady_) {
+        isReady_ = true;
+        condition_.notify_one();
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionCapture::flush} /////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionCapture::flush() {
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+    if (buffer_.getLength() > 0 && !isReady_) {
+        isReady_ = true;
+        condition_.notify_one();
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionCapture::run} ///////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionCapture::run() {
+    while (true) {
+        {
+            // =================== Lock ===================
+            boost::mutex::scoped_lock lock(mutex_);
+            // =================== Lock ===================
+            while (!isReady_ && isRunning_) {
+                condition_.wait(lock);
+            }
+            if (!isReady_) {
+                return;
+            }
+
+            // The records are swapped with the empty buffer written
+            // last time, only the writer touches the other one.
+            std::swap(buffer_, pending_);
+            isReady_ = false;
+        }
+        doWrite(pending_);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionCapture::doWrite} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionCapture::doWrite(MessageBuffer & buffer) {
+    if (std::fwrite(buffer.getData(), 1, buffer.getLength(), file_) != buffer.getLength()) {
+        BOOST_LOG_TRIVIAL(error)
+                << "[*] <SessionCapture> Failed to write the capture, records were lost.";
+    }
+    std::fflush(file_);
+    buffer.clear();
+}
\ No newline at end of file
@@ -15,5 +15,543 @@
  */
 
 #include <Network/SessionManager.hpp>
+#include <future>
+#include <stdexcept>
 
-using namespace Ghrum;
\ No newline at end of file
+using namespace Ghrum;
+
+#ifdef SO_REUSEPORT
+/**
+ * Socket option to share a port between many sockets, the kernel
+ * spreads the incoming connections between them.
+ */
+typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port;
+#endif
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::SessionManager} ////////////////////////
+/////////////////////////////////////////////////////////////////
+SessionManager::SessionManager()
+    : isShared_(false), nextId_(0), nextReactor_(0), isCapturing_(false), writes_(0), messages_(0), drops_(0), slows_(0),
+      connect_([](Session &) {}), disconnect_([](Session &) {}),
+      message_([](Session &, MessageInputStream &) {}), congestion_([](Session &, bool) {}) {
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::~SessionManager} ///////////////////////
+/////////////////////////////////////////////////////////////////
+SessionManager::~SessionManager() {
+    stop();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::start} /////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::start(const std::string & address, uint16_t port, size_t reactors) {
+    if (reactors == 0) {
+        reactors = std::max<size_t>(1, boost::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < reactors; i++) {
+        reactor_.push_back(std::unique_ptr<Reactor>(new Reactor(i)));
+    }
+    queued_.resize(reactors);
+
+    // Open an acceptor in every reactor sharing the same port, or
+    // a single acceptor when the port can't be shared.
+    boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::address::from_string(address), port);
+#ifdef SO_REUSEPORT
+    isShared_ = true;
+#endif
+    for (size_t i = 0; i < (isShared_ ? reactors : 1); i++) {
+        std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor(
+            new boost::asio::ip::tcp::acceptor(reactor_[i]->getService()));
+        acceptor->open(endpoint.protocol());
+        acceptor->set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+        acceptor->set_option(reuse_port(true));
+#endif
+        acceptor->bind(endpoint);
+        acceptor->listen();
+
+        // Every other acceptor binds to the port picked by the first.
+        endpoint = acceptor->local_endpoint();
+        acceptor_.push_back(std::move(acceptor));
+        backoff_.push_back(std::unique_ptr<boost::asio::deadline_timer>(
+                               new boost::asio::deadline_timer(reactor_[i]->getService())));
+    }
+
+    BOOST_LOG_TRIVIAL(info)
+            << "[*] <SessionManager> Listening at " << endpoint << " with " << reactors << " reactors.";
+    for (size_t i = 0; i < acceptor_.size(); i++) {
+        doAccept(i);
+    }
+    for (auto & reactor : reactor_) {
+        reactor->start();
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::stop} //////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::stop() {
+    // Every session is closed in its own reactor, so the disconnect
+    // delegate is called for each of them before the reactors stop.
+    // A session accepted meanwhile is closed along with the others.
+    stopAccepting();
+    doWait();
+    std::vector<std::shared_ptr<Session>> sessions;
+    {
+        // =================== Lock ===================
+        boost::mutex::scoped_lock lock(mutex_);
+        // =================== Lock ===================
+        for (auto & entry : session_) {
+            sessions.push_back(entry.second);
+        }
+    }
+    for (auto & session : sessions) {
+        session->close();
+    }
+    doWait();
+    stopCapture();
+
+    // Once every reactor is stopped, no handler can touch the sessions
+    // or the acceptors anymore.
+    for (auto & reactor : reactor_) {
+        reactor->stop();
+    }
+    {
+        // =================== Lock ===================
+        boost::mutex::scoped_lock lock(mutex_);
+        // =================== Lock ===================
+        session_.clear();
+    }
+    backoff_.clear();
+    acceptor_.clear();
+    queued_.clear();
+    reactor_.clear();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::stopAccepting} /////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::stopAccepting() {
+    // Every acceptor is closed by its own reactor, the accept pending
+    // completes as aborted.
+    for (size_t i = 0; i < acceptor_.size(); i++) {
+        reactor_[i]->getService().post([this, i]() {
+            backoff_[i]->cancel();
+            acceptor_[i]->close();
+        });
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::flush} /////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::flush() {
+    // A single handler per reactor, each reactor flushes the sessions
+    // it owns.
+    for (size_t i = 0; i < reactor_.size(); i++) {
+        reactor_[i]->getService().post([this, i]() {
+            doFlush(i);
+        });
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::broadcast} /////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::broadcast(MessageOutputStream & stream, bool isDroppable) {
+    std::vector<std::shared_ptr<Session>> sessions;
+    {
+        // =================== Lock ===================
+        boost::mutex::scoped_lock lock(mutex_);
+        // =================== Lock ===================
+        sessions.reserve(session_.size());
+        for (auto & entry : session_) {
+            sessions.push_back(entry.second);
+        }
+    }
+    doBroadcast(sessions, stream.share(), isDroppable);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::broadcast} /////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::broadcast(const std::vector<std::shared_ptr<Session>> & sessions,
+                               MessageOutputStream & stream, bool isDroppable) {
+    doBroadcast(sessions, stream.share(), isDroppable);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::startCapture} //////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::startCapture(const std::string & path) {
+    std::shared_ptr<SessionCapture> capture = std::make_shared<SessionCapture>(path, parser_);
+    std::atomic_store(&capture_, capture);
+    isCapturing_ = true;
+
+    BOOST_LOG_TRIVIAL(info)
+            << "[*] <SessionManager> Capturing every session into " << path << ".";
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::stopCapture} ///////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::stopCapture() {
+    // A session recording meanwhile holds the capture, which is closed
+    // by whoever releases it last.
+    isCapturing_ = false;
+    std::atomic_store(&capture_, std::shared_ptr<SessionCapture>());
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::createReplaySession} ///////////////////
+/////////////////////////////////////////////////////////////////
+std::shared_ptr<Session> SessionManager::createReplaySession() {
+    if (reactor_.empty()) {
+        throw std::runtime_error("The manager must be started before a replay");
+    }
+    Reactor & reactor = *reactor_[nextReactor_.fetch_add(1) % reactor_.size()];
+    std::shared_ptr<Session> session = std::make_shared<Session>(*this, reactor, ++nextId_);
+    {
+        // =================== Lock ===================
+        boost::mutex::scoped_lock lock(mutex_);
+        // =================== Lock ===================
+        session_[session->getId()] = session;
+    }
+    reactor.getService().dispatch([this, session]() {
+        session->startReplay();
+        connect_(*session);
+    });
+    return session;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::setConnectDelegate} ////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::setConnectDelegate(SessionDelegate callback) {
+    connect_ = callback;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::setDisconnectDelegate} /////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::setDisconnectDelegate(SessionDelegate callback) {
+    disconnect_ = callback;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::setMessageDelegate} ////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::setMessageDelegate(MessageDelegate callback) {
+    message_ = callback;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::setCongestionDelegate} /////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::setCongestionDelegate(CongestionDelegate callback) {
+    congestion_ = callback;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::setSendLimit} //////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::setSendLimit(const SessionSendLimit & limit) {
+    limit_ = limit;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::getSendLimit} //////////////////////////
+/////////////////////////////////////////////////////////////////
+const SessionSendLimit & SessionManager::getSendLimit() {
+    return limit_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::setFrameParser} ////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::setFrameParser(const MessageFrameParser & parser) {
+    parser_ = parser;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::getFrameParser} ////////////////////////
+/////////////////////////////////////////////////////////////////
+const MessageFrameParser & SessionManager::getFrameParser() {
+    return parser_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::getSession} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+std::shared_ptr<Session> SessionManager::getSession(size_t id) {
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+
+    std::unordered_map<size_t, std::shared_ptr<Session>>::iterator it = session_.find(id);
+    return (it != session_.end() ? it->second : nullptr);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::getSessionCount} ///////////////////////
+/////////////////////////////////////////////////////////////////
+size_t SessionManager::getSessionCount() {
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+
+    return session_.size();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::getReactorCount} ///////////////////////
+/////////////////////////////////////////////////////////////////
+size_t SessionManager::getReactorCount() {
+    return reactor_.size();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::getPort} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+uint16_t SessionManager::getPort() {
+    return (acceptor_.empty() ? 0 : acceptor_[0]->local_endpoint().port());
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::getWriteCount} /////////////////////////
+/////////////////////////////////////////////////////////////////
+uint64_t SessionManager::getWriteCount() {
+    return writes_.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::getMessageCount} ///////////////////////
+/////////////////////////////////////////////////////////////////
+uint64_t SessionManager::getMessageCount() {
+    return messages_.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::getDropCount} //////////////////////////
+/////////////////////////////////////////////////////////////////
+uint64_t SessionManager::getDropCount() {
+    return drops_.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::getSlowCount} //////////////////////////
+/////////////////////////////////////////////////////////////////
+uint64_t SessionManager::getSlowCount() {
+    return slows_.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::getQueueDepth} /////////////////////////
+/////////////////////////////////////////////////////////////////
+size_t SessionManager::getQueueDepth() {
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+
+    size_t depth = 0;
+    for (auto & entry : session_) {
+        depth += entry.second->getQueueDepth();
+    }
+    return depth;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::onRead} ////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::onRead(Session & session, const int8_t * data, size_t length) {
+    doCapture(SessionRecord::Receive, session, data, length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::onReceive} /////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::onReceive(Session & session, MessageInputStream & stream) {
+    message_(session, stream);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::onQueue} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::onQueue(Session & session) {
+    queued_[session.getReactor().getId()].push_back(session.shared_from_this());
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::onWrite} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::onWrite(Session &, size_t messages) {
+    writes_.fetch_add(1, std::memory_order_relaxed);
+    messages_.fetch_add(messages, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::onCongestion} //////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::onCongestion(Session & session, bool isCongested) {
+    congestion_(session, isCongested);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::onDrop} ////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::onDrop() {
+    drops_.fetch_add(1, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::onSlow} ////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::onSlow() {
+    slows_.fetch_add(1, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::onClose} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::onClose(Session & session) {
+    doCapture(SessionRecord::Close, session);
+    disconnect_(session);
+
+    // =================== Lock ===================
+    boost::mutex::scoped_lock lock(mutex_);
+    // =================== Lock ===================
+    session_.erase(session.getId());
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::doAccept} //////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::doAccept(size_t index) {
+    if (!acceptor_[index]->is_open()) {
+        return;
+    }
+
+    // A shared acceptor keeps its sessions, a single acceptor spreads
+    // them between every reactor.
+    Reactor & reactor = (isShared_
+                         ? *reactor_[index]
+                         : *reactor_[nextReactor_.fetch_add(1) % reactor_.size()]);
+    std::shared_ptr<Session> session = std::make_shared<Session>(*this, reactor, ++nextId_);
+    acceptor_[index]->async_accept(session->getSocket(),
+    [this, index, session](const boost::system::error_code & error) {
+        onAccept(index, session, error);
+    });
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::onAccept} //////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::onAccept(size_t index, std::shared_ptr<Session> session,
+                              const boost::system::error_code & error) {
+    if (error == boost::asio::error::operation_aborted) {
+        return;
+    }
+
+    // Failures such as running out of descriptors last until another
+    // session closes, accepting again right away would only spin.
+    if (error) {
+        BOOST_LOG_TRIVIAL(warning)
+                << "[*] <SessionManager> Failed to accept a session: " << error.message();
+        backoff_[index]->expires_from_now(boost::posix_time::milliseconds(SESSION_ACCEPT_BACKOFF));
+        backoff_[index]->async_wait([this, index](const boost::system::error_code & error) {
+            if (error != boost::asio::error::operation_aborted)
+                doAccept(index);
+        });
+        return;
+    }
+    {
+        // =================== Lock ===================
+        boost::mutex::scoped_lock lock(mutex_);
+        // =================== Lock ===================
+        session_[session->getId()] = session;
+    }
+
+    // The session starts in its own reactor, which may not be
+    // the reactor of the acceptor.
+    Reactor & reactor = session->getReactor();
+    reactor.getService().dispatch([this, session]() {
+        session->start();
+        doCapture(SessionRecord::Connect, *session);
+        connect_(*session);
+    });
+    doAccept(index);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::doWait} ////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::doWait() {
+    std::vector<std::future<void>> done;
+    for (auto & reactor : reactor_) {
+        std::shared_ptr<std::promise<void>> promise = std::make_shared<std::promise<void>>();
+        done.push_back(promise->get_future());
+        reactor->getService().post([promise]() {
+            promise->set_value();
+        });
+    }
+    for (auto & future : done) {
+        future.wait();
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::doCapture} /////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::doCapture(SessionRecord record, Session & session, const int8_t * data, size_t length) {
+    // Without a capture in progress, the shared capture isn't even
+    // loaded.
+    if (!isCapturing_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::shared_ptr<SessionCapture> capture = std::atomic_load(&capture_);
+    if (capture) {
+        capture->write(record, session.getId(), data, length);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::doFlush} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::doFlush(size_t index) {
+    // Sessions queued while flushing are left for the next flush, the
+    // list keeps its capacity between ticks.
+    std::vector<std::shared_ptr<Session>> & queue = queued_[index];
+    size_t length = queue.size();
+    for (size_t i = 0; i < length; i++) {
+        queue[i]->flush();
+    }
+    queue.erase(queue.begin(), queue.begin() + length);
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionManager::doBroadcast} ///////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionManager::doBroadcast(const std::vector<std::shared_ptr<Session>> & sessions,
+                                 std::shared_ptr<const MessageBuffer> buffer, bool isDroppable) {
+    // Group the sessions by reactor, so each reactor gets a single
+    // handler instead of one per session.
+    std::vector<std::vector<std::shared_ptr<Session>>> group(reactor_.size());
+    for (const std::shared_ptr<Session> & session : sessions) {
+        group[session->getReactor().getId()].push_back(session);
+    }
+    for (size_t i = 0; i < group.size(); i++) {
+        if (group[i].empty()) {
+            continue;
+        }
+        std::shared_ptr<std::vector<std::shared_ptr<Session>>> target
+            = std::make_shared<std::vector<std::shared_ptr<Session>>>(std::move(group[i]));
+        reactor_[i]->getService().dispatch([target, buffer, isDroppable]() {
+            for (const std::shared_ptr<Session> & session : *target) {
+                session->send(buffer, isDroppable);
+            }
+        });
+    }
+}
\ No newline at end of file
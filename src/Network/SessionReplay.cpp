@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2013 Ghrum Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Network/SessionReplay.hpp>
+#include <stdexcept>
+
+using namespace Ghrum;
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionReplay::SessionReplay} //////////////////////////
+/////////////////////////////////////////////////////////////////
+SessionReplay::SessionReplay(SessionManager & manager, const std::string & path)
+    : manager_(manager), offset_(0), pending_(0), records_(0), bytes_(0), sessions_(0), elapsed_(0) {
+    try {
+        file_ = boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only);
+        region_ = boost::interprocess::mapped_region(file_, boost::interprocess::read_only);
+    } catch (boost::interprocess::interprocess_exception & ex) {
+        throw std::runtime_error("Failed to map the capture " + path + ": " + ex.what());
+    }
+    region_.advise(boost::interprocess::mapped_region::advice_sequential);
+
+    // The frames are parsed by the parser of the manager, which must
+    // split them as they were split when captured.
+    MessageInputStream stream(static_cast<const int8_t *>(region_.get_address()), region_.get_size());
+    stream.setEndianness(false);
+    try {
+        if (stream.readUnsignedInteger() != SESSION_CAPTURE_MAGIC
+                || stream.readUnsignedByte() != SESSION_CAPTURE_VERSION) {
+            throw std::runtime_error("Not a capture " + path);
+        }
+        const MessageFrameParser & parser = manager_.getFrameParser();
+        MessageFramePrefix prefix = MessageFramePrefix(stream.readUnsignedByte());
+        bool isBigEndianness = stream.readBoolean();
+        stream.readVarUnsignedLong();
+        if (prefix != parser.getPrefix() || isBigEndianness != parser.isBigEndianness()) {
+            throw std::runtime_error("The capture " + path + " has other frames than the manager");
+        }
+    } catch (std::out_of_range &) {
+        throw std::runtime_error("Not a capture " + path);
+    }
+    offset_ = region_.get_size() - stream.getLength();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionReplay::run} ////////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionReplay::run(bool isRealtime) {
+    if (manager_.getReactorCount() == 0) {
+        throw std::runtime_error("The manager must be started before a replay");
+    }
+    records_ = bytes_ = sessions_ = 0;
+
+    // Only the sessions of the capture go through the manager, as live
+    // traffic would make every replay a different one.
+    manager_.stopAccepting();
+
+    // Every session is replayed by a new session of the manager, the
+    // records of a session unknown to the capture are skipped.
+    std::unordered_map<uint64_t, std::shared_ptr<Session>> sessions;
+    MessageInputStream stream(static_cast<const int8_t *>(region_.get_address()) + offset_,
+                              region_.get_size() - offset_);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t time = 0;
+
+    try {
+        while (stream.getLength() > 0) {
+            SessionRecord record = SessionRecord(stream.readUnsignedByte());
+            time += stream.readVarUnsignedLong();
+            uint64_t id = stream.readVarUnsignedLong();
+            const int8_t * data = nullptr;
+            size_t length = 0;
+            if (record == SessionRecord::Receive) {
+                length = size_t(stream.readVarUnsignedLong());
+                data = stream.readRaw(length);
+            } else if (record != SessionRecord::Connect && record != SessionRecord::Close) {
+                throw std::runtime_error("Unknown record");
+            }
+            records_++;
+
+            // At the original pace every record waits for its time, as
+            // fast as possible the reactors are kept from falling too far
+            // behind. The sessions are flushed by the ticks, as ever.
+            if (isRealtime) {
+                std::chrono::nanoseconds ahead = std::chrono::nanoseconds(time)
+                                                 - (std::chrono::steady_clock::now() - start);
+                if (ahead.count() > 0) {
+                    boost::this_thread::sleep(boost::posix_time::microseconds(ahead.count() / 1000));
+                }
+            } else {
+                doWait(SESSION_REPLAY_WINDOW);
+            }
+
+            std::unordered_map<uint64_t, std::shared_ptr<Session>>::iterator it = sessions.find(id);
+            switch (record) {
+            case SessionRecord::Connect:
+                sessions[id] = manager_.createReplaySession();
+                sessions_++;
+                break;
+            case SessionRecord::Receive:
+                if (it != sessions.end()) {
+                    std::shared_ptr<Session> session = it->second;
+                    pending_.fetch_add(1, std::memory_order_relaxed);
+                    session->getReactor().getService().post([this, session, data, length]() {
+                        session->receive(data, length);
+                        pending_.fetch_sub(1, std::memory_order_release);
+                    });
+                    bytes_ += length;
+                }
+                break;
+            case SessionRecord::Close:
+                if (it != sessions.end()) {
+                    it->second->close();
+                    sessions.erase(it);
+                }
+                break;
+            }
+        }
+    } catch (std::exception & ex) {
+        BOOST_LOG_TRIVIAL(warning)
+                << "[*] <SessionReplay> Stopped at a malformed record, " << ex.what();
+    }
+
+    // The bytes handed to the reactors live in the mapped capture, so
+    // they must be processed before returning.
+    for (auto & entry : sessions) {
+        entry.second->close();
+    }
+    doWait(0);
+    elapsed_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - start).count();
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionReplay::getRecordCount} /////////////////////////
+/////////////////////////////////////////////////////////////////
+uint64_t SessionReplay::getRecordCount() {
+    return records_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionReplay::getByteCount} ///////////////////////////
+/////////////////////////////////////////////////////////////////
+uint64_t SessionReplay::getByteCount() {
+    return bytes_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionReplay::getSessionCount} ////////////////////////
+/////////////////////////////////////////////////////////////////
+uint64_t SessionReplay::getSessionCount() {
+    return sessions_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionReplay::getElapsed} /////////////////////////////
+/////////////////////////////////////////////////////////////////
+uint64_t SessionReplay::getElapsed() {
+    return elapsed_;
+}
+
+/////////////////////////////////////////////////////////////////
+// {@see SessionReplay::doWait} /////////////////////////////////
+/////////////////////////////////////////////////////////////////
+void SessionReplay::doWait(size_t window) {
+    while (pending_.load(std::memory_order_acquire) > window) {
+        boost::this_thread::yield();
+    }
+}
\ No newline at end of file
@@ -24,7 +24,7 @@ using namespace Ghrum;
 /////////////////////////////////////////////////////////////////
 Scheduler::Scheduler()
     : active_(true), overloaded_(false), uptime_(0), iterationPerSecond_(60),
-      thread_(boost::thread::hardware_concurrency()) {
+      thread_(boost::thread::hardware_concurrency()), nextTick_(0) {
 }
 
 /////////////////////////////////////////////////////////////////
@@ -62,6 +62,11 @@ void Scheduler::runMainThread() {
             runTaskQueue(syncronizedQueue);
         }
 
+        // Run every delegate that must be executed once per tick.
+        for (auto & delegate : tickDelegate_) {
+            delegate();
+        }
+
         // Check the timing of the scheduler and populate
         // accounting information.
         if (++uptime_ < nextTick_) {
@@ -86,6 +91,13 @@ void Scheduler::runMainThread() {
     workerGroup_.joinAll();
 }
 
+/////////////////////////////////////////////////////////////////
+// {@see Scheduler::setCancelled} ///////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Scheduler::setCancelled() {
+    active_ = false;
+}
+
 /////////////////////////////////////////////////////////////////
 // {@see Scheduler::isActive} ///////////////////////////////////
 /////////////////////////////////////////////////////////////////
@@ -194,6 +206,13 @@ ITask & Scheduler::asyncAnonymousTask(Delegate<void()> callback, TaskPriority pr
     return static_cast<ITask &>(*task);
 }
 
+/////////////////////////////////////////////////////////////////
+// {@see Scheduler::addTickDelegate} ////////////////////////////
+/////////////////////////////////////////////////////////////////
+void Scheduler::addTickDelegate(Delegate<void()> callback) {
+    tickDelegate_.push_back(callback);
+}
+
 /////////////////////////////////////////////////////////////////
 // {@see Scheduler::runTaskParallel} ////////////////////////////
 /////////////////////////////////////////////////////////////////